@@ -1,7 +1,18 @@
 #include "IOhandler.h"
 #include "chess-peice-codes.h"
+#include "chess-perft.h"
+#include "chess-search.h"
+#include "chess-thread-pool.h"
+#include "chess-transposition.h"
+#include <new>
 #include <unistd.h>
 
+/**
+ * @brief Deepest perft the perft command runs. It has no deadline and the
+ *        session waits for it, so deeper counts are left to chess-perft.
+ */
+static const int MAX_COMMAND_PERFT_DEPTH = 7;
+
 /**
  * @brief Checks for checkmate or stalemate conditions for a given side.
  *
@@ -9,7 +20,7 @@
  * stalemate, or can still make valid moves.
  *
  * @param side Indicates the side to evaluate (true for white, false for black).
- * @param board Pointer to the 2D array (8x8) of ChessPieceBase pointers.
+ * @param chessBoard The board to evaluate.
  * @param checkMate Reference to a Special_Parameter struct that will be filled
  *        with information about any discovered checkmate or restricted moves.
  * @return 
@@ -17,37 +28,15 @@
  * - 0 if a stalemate is detected (no moves, not in check).
  * - -1 if a checkmate is detected.
  */
-int patOrMate(bool side, ChessPieceBase ***board, Special_Parameter &checkMate) {
+int patOrMate(bool side, ChessBoard *chessBoard, Special_Parameter &checkMate) {
   // Evaluate the board to see if the king is in check and gather any restrictions.
-  checkMate = ChessBoard::evaluateCheckMate(side, board);
-
-  // Loop through all squares to find pieces belonging to the given side.
-  for (int row = 0; row < BOARDSIZE; ++row) {
-    for (int col = 0; col < BOARDSIZE; ++col) {
-      if (board[row][col]->isWhite() == side) {
-        // Collect attack candidates.
-        std::vector<std::pair<int, int>> candidateMoves =
-            board[row][col]->getAttackCandidates(false);
-
-        // Also collect normal move candidates.
-        for (std::pair<int, int> move : board[row][col]->getMoveCandidates()) {
-          candidateMoves.push_back(move);
-        }
+  checkMate = ChessBoard::evaluateCheckMate(side, chessBoard);
 
-        // If the piece is restricted because the king is in check or pinned.
-        int id = ChessBoard::findFigureIndex(checkMate.restrictions, {row, col});
-        if ((checkMate.kingAttacked || id != -1) &&
-            board[row][col]->getCode() != KING) {
-          // Filter out moves that are not allowed under the current check constraints.
-          candidateMoves = ChessBoard::filterMoves(candidateMoves, checkMate, id);
-        }
-
-        // If we find any legal move, we can return immediately.
-        if (!candidateMoves.empty()) {
-          return 1; // Valid moves exist
-        }
-      }
-    }
+  // If there is any legal move, it is neither mate nor stalemate.
+  MoveList legalMoves;
+  chessBoard->generateLegalMoves(side, legalMoves);
+  if (!legalMoves.empty()) {
+    return 1; // Valid moves exist
   }
   // If no valid moves are found, return negative or zero based on whether the king is attacked.
   // -1 indicates checkmate (kingAttacked == true), 0 indicates stalemate (kingAttacked == false).
@@ -186,13 +175,19 @@ std::vector<std::string> IOhandler::getPossibleOptions() {
   std::vector<std::string> out;
   out.push_back("exit\t\t\texits the game");
   out.push_back("help\t\t\tdisplays this help");
+  out.push_back("engine <drunk|alphabeta>\tselects the search");
+  out.push_back("hash <megabytes>\tresizes the transposition table");
+  out.push_back("threads <count>\t\tsets the threads a search runs on");
+  out.push_back("quiescence <plies>\tcaptures the selected search follows past its last ply");
 
   if (!gameIsOn) {
     out.push_back("start\t\t\tstarts a game");
   } else {
     out.push_back("move <start:end>\tperforms specified move");
+    out.push_back("move enemy [ms]\t\tthe AI moves, within ms milliseconds if given");
     out.push_back("surrender\t\tyou instantly lose");
     out.push_back("print\t\t\tprints a board");
+    out.push_back("perft [divide] <depth>\tcounts move tree leaves");
   }
   return out;
 }
@@ -233,10 +228,20 @@ void IOhandler::processInput(const std::string &response) {
         *output << "Unknown input " << std::endl;
       }
     }
+  } else if (gameIsOn && response.substr(0, 11) == "move enemy ") {
+    // The clock starts as the command arrives
+    auto received = std::chrono::steady_clock::now();
+    int milliseconds = std::stoi(response.substr(11));
+    if (milliseconds <= 0) {
+      throw std::invalid_argument("DEADLINE MUST BE POSITIVE");
+    }
+    move("enemy", received + std::chrono::milliseconds(milliseconds));
   } else if (gameIsOn && response.size() == 10 && response.substr(0, 4) == "move") {
     move(response.substr(5, 10));
   } else if (gameIsOn && response.size() == 8 && response.substr(0, 5) == "moves") {
     printMoveCandidates(response.substr(6, 8));
+  } else if (gameIsOn && response.substr(0, 6) == "perft ") {
+    printPerft(response.substr(6));
   } else if (gameIsOn && response == "surrender") {
     if (ch) {
       delete ch;
@@ -250,6 +255,14 @@ void IOhandler::processInput(const std::string &response) {
     gameIsOn = false;
   } else if (response == "prestart") {
     gameIsOn = startPreDefinedGame();
+  } else if (response.substr(0, 7) == "engine ") {
+    setEngine(response.substr(7));
+  } else if (response.substr(0, 5) == "hash ") {
+    setHashSize(response.substr(5));
+  } else if (response.substr(0, 8) == "threads ") {
+    setThreads(response.substr(8));
+  } else if (response.substr(0, 11) == "quiescence ") {
+    setQuiescence(response.substr(11));
   } else if (response == "set params") {
     setParams();
   } else if (gameIsOn && response == "print") {
@@ -273,6 +286,8 @@ bool IOhandler::startPreDefinedGame() {
     delete ch;
     ch = nullptr;
   }
+  transpositionTable.clear();
+  AlphaBetaSearch::clearHistory();
   checkMate = {false, {}, {}};
 
   if (server) {
@@ -329,6 +344,16 @@ std::pair<int, int> IOhandler::transcodePosition(std::string str) {
   }
 }
 
+/**
+ * @brief Converts board coordinates back into the two-digit form of the current side.
+ */
+std::string IOhandler::encodePosition(std::pair<int, int> pos) {
+  if (side) {
+    return std::to_string(pos.second) + std::to_string(pos.first);
+  }
+  return std::to_string(7 - pos.second) + std::to_string(7 - pos.first);
+}
+
 /**
  * @brief Starts a new game from scratch, asking for a difficulty level.
  * 
@@ -339,6 +364,8 @@ bool IOhandler::startGame() {
     delete ch;
     ch = nullptr;
   }
+  transpositionTable.clear();
+  AlphaBetaSearch::clearHistory();
   checkMate = {false, {}, {}};
 
   std::string response_ =
@@ -376,10 +403,10 @@ void IOhandler::dumpCurrentGamestate() {
   short val;
   for (i = 0; i < BOARDSIZE; ++i) {
     for (j = 0; j < BOARDSIZE; ++j) {
-      val = ChessPieceBase::getSymb(ch->getBoard()[i][j]->getCode());
+      val = ChessPieceBase::getSymb(ch->getPiece(i, j).getCode());
       val = val << 3;
-      val += ch->getBoard()[i][j]->isWhite() << 1;
-      val += ch->getBoard()[i][j]->hasMoved();
+      val += ch->getPiece(i, j).isWhite() << 1;
+      val += ch->getPiece(i, j).hasMoved();
       outData += std::to_string(val) + ' ';
     }
   }
@@ -472,6 +499,88 @@ void IOhandler::setParams() {
   } catch (...) {
     std::cerr << "INVALID VALUE";
   }
+  // Stored scores were computed with the old prices
+  transpositionTable.clear();
+}
+
+/**
+ * @brief Selects the search used for the AI's moves, for this and later games.
+ * @param name "drunk" (or "beam") or "alphabeta".
+ * @throws std::invalid_argument If the name is unknown.
+ */
+void IOhandler::setEngine(const std::string &name) {
+  if (name == "drunk" || name == "beam") {
+    searchEngine = BEAM;
+  } else if (name == "alphabeta") {
+    searchEngine = ALPHA_BETA;
+  } else {
+    throw std::invalid_argument("UNKNOWN ENGINE");
+  }
+
+  *output << (server ? "OK" : "Engine set to " + name) << std::endl;
+  if (log) {
+    log->log("ENGINE SET TO " + name);
+  }
+}
+
+/**
+ * @brief Resizes the transposition table, dropping its entries. If the memory
+ *        cannot be had, the old table is kept as it was.
+ * @param megabytes The new size in megabytes.
+ * @throws std::invalid_argument If the size is not a number between 1 and
+ *         TranspositionTable::MAX_MEGABYTES, or the memory cannot be had.
+ */
+void IOhandler::setHashSize(const std::string &megabytes) {
+  int size = std::stoi(megabytes);
+  if (size <= 0) {
+    throw std::invalid_argument("HASH SIZE MUST BE POSITIVE");
+  }
+  try {
+    transpositionTable.resize(size_t(size));
+  } catch (std::bad_alloc &) {
+    throw std::invalid_argument("NOT ENOUGH MEMORY FOR THE HASH TABLE");
+  }
+
+  *output << (server ? "OK" : "Hash set to " + std::to_string(size) + " MB") << std::endl;
+  if (log) {
+    log->log("HASH SET TO " + std::to_string(size) + " MB");
+  }
+}
+
+/**
+ * @brief Resizes the thread pool later searches run on.
+ * @param count The new thread count.
+ * @throws std::invalid_argument If the count is not a positive number.
+ */
+void IOhandler::setThreads(const std::string &count) {
+  int threads = std::stoi(count);
+  threadPool.resize(threads);
+
+  *output << (server ? "OK" : "Threads set to " + std::to_string(threads)) << std::endl;
+  if (log) {
+    log->log("THREADS SET TO " + std::to_string(threads));
+  }
+}
+
+/**
+ * @brief Sets how far the selected search follows captures past its last ply.
+ * @param plies The new ply count.
+ * @throws std::invalid_argument If the count is negative or not a number.
+ */
+void IOhandler::setQuiescence(const std::string &plies) {
+  int count = std::stoi(plies);
+  if (count < 0) {
+    throw std::invalid_argument("QUIESCENCE PLIES MUST NOT BE NEGATIVE");
+  }
+  quiescencePlies[searchEngine] = count;
+  // Stored scores were searched with the old horizon
+  transpositionTable.clear();
+
+  *output << (server ? "OK" : "Quiescence set to " + std::to_string(count) + " plies")
+          << std::endl;
+  if (log) {
+    log->log("QUIESCENCE SET TO " + std::to_string(count) + " PLIES");
+  }
 }
 
 /**
@@ -481,9 +590,10 @@ void IOhandler::setParams() {
  * and handles finishing the game if necessary. If "enemy" is specified, calls the AI to move.
  *
  * @param move The input string with move coordinates or the word "enemy".
+ * @param deadline When the AI's move is due.
  * @throws std::logic_error If the move is not valid under current game constraints.
  */
-void IOhandler::move(const std::string &move) {
+void IOhandler::move(const std::string &move, Deadline deadline) {
   Move mv;
   Move bestMove;
   bool isGood = true;
@@ -492,12 +602,12 @@ void IOhandler::move(const std::string &move) {
   // If "enemy" is specified, let the AI move.
   if (move == "enemy") {
     try {
-      bestMove = ch->getBestMove(!this->side);
+      bestMove = ch->getBestMove(!this->side, deadline);
       if (bestMove.start.first == -1) {
         // If AI has no moves, check whether it's checkmate or stalemate.
         if (ChessBoard::simplifiedEvaluateCheckMate(
-                !this->side, ChessBoard::findKing(!this->side, ch->getBoard()),
-                ch->getBoard())) {
+                !this->side, ChessBoard::findKing(!this->side, ch),
+                ch)) {
           if (log) {
             log->log("COMPUTER LOST");
           }
@@ -523,7 +633,7 @@ void IOhandler::move(const std::string &move) {
         log->log("COMPUTER MOVED: " + Logger::moveToString(bestMove));
       }
 
-      id = patOrMate(side, ch->getBoard(), checkMate);
+      id = patOrMate(side, ch, checkMate);
       if (id == -1) {
         if (log) {
           log->log("PLAYER LOST");
@@ -568,8 +678,8 @@ void IOhandler::move(const std::string &move) {
         transcodePosition(move.substr(3, 5))};
 
   // Check if the piece belongs to the current player and is not empty.
-  if (ch->getBoard()[mv.start.first][mv.start.second]->isWhite() == this->side &&
-      ch->getBoard()[mv.start.first][mv.start.second]->getCode() != EMPTY) {
+  if (ch->getPiece(mv.start.first, mv.start.second).isWhite() == this->side &&
+      ch->getPiece(mv.start.first, mv.start.second).getCode() != EMPTY) {
 
     // Prevent moves to the same square.
     if (mv.start == mv.end) {
@@ -577,7 +687,7 @@ void IOhandler::move(const std::string &move) {
     }
 
     // Evaluate checkmate restrictions for current side.
-    checkMate = ChessBoard::evaluateCheckMate(this->side, ch->getBoard());
+    checkMate = ChessBoard::evaluateCheckMate(this->side, ch);
     id = ChessBoard::findFigureIndex(checkMate.restrictions, mv.start);
 
     // If the piece is pinned or the king is under attack, verify that the chosen move is valid.
@@ -594,7 +704,7 @@ void IOhandler::move(const std::string &move) {
     }
 
     // A king is free to move if the move is valid for the king, ignoring certain pinned constraints.
-    if (isGood || ch->getBoard()[mv.start.first][mv.start.second]->getCode() == KING) {
+    if (isGood || ch->getPiece(mv.start.first, mv.start.second).getCode() == KING) {
       try {
         ch->performMove(mv, this);
         if (log) {
@@ -651,16 +761,17 @@ ChessPieceCode IOhandler::askReplacement(bool side) {
  */
 void IOhandler::printMoveCandidates(std::string start) {
   std::pair<int, int> pos = transcodePosition(start);
-  std::vector<std::pair<int, int>> candidates =
-      ch && ch->getBoard()[pos.first][pos.second]->isWhite() == side
-          ? getMoveCandidates(pos)
-          : std::vector<std::pair<int, int>>{};
+  MoveList candidates;
+  if (ch && ch->getPiece(pos.first, pos.second).isWhite() == side) {
+    getMoveCandidates(pos, candidates);
+  }
 
   if (candidates.empty()) {
     *output << "NONE" << std::endl;
   } else {
     int counter = 0;
-    for (std::pair<int, int> el : candidates) {
+    for (PackedMove candidate : candidates) {
+      std::pair<int, int> el = unpackMove(candidate).end;
       int row, col;
       // Convert back for printing if the user plays black (reverse board).
       if (side) {
@@ -680,6 +791,35 @@ void IOhandler::printMoveCandidates(std::string start) {
   }
 }
 
+/**
+ * @brief Runs perft for the player's side on a copy of the board.
+ *
+ * Output is one "<start>:<end> <nodes>" line per root move in divide mode, then
+ * "nodes <n> time <ms> nps <n>".
+ *
+ * @param args "<depth>" or "divide <depth>".
+ * @throws std::invalid_argument If the depth is missing, malformed or outside
+ *         0 to MAX_COMMAND_PERFT_DEPTH.
+ */
+void IOhandler::printPerft(const std::string &args) {
+  bool divide = args.substr(0, 7) == "divide ";
+  int depth = std::stoi(divide ? args.substr(7) : args);
+  if (depth < 0 || depth > MAX_COMMAND_PERFT_DEPTH) {
+    throw std::invalid_argument("PERFT DEPTH MUST BE BETWEEN 0 AND " +
+                                std::to_string(MAX_COMMAND_PERFT_DEPTH));
+  }
+
+  ChessBoard board(ch);
+  Perft_Result result = runPerft(&board, side, depth, divide);
+  for (const auto &entry : result.divide) {
+    Move move = unpackMove(entry.first);
+    *output << encodePosition(move.start) << ':' << encodePosition(move.end) << ' '
+            << entry.second << std::endl;
+  }
+  *output << "nodes " << result.nodes << " time " << int64_t(result.seconds * 1000)
+          << " nps " << result.nodesPerSecond() << std::endl;
+}
+
 /**
  * @brief Collects combined move and attack candidates for a piece at the given position.
  * 
@@ -687,36 +827,19 @@ void IOhandler::printMoveCandidates(std::string start) {
  * to save the king).
  *
  * @param start Pair of integers (row, col) indicating the position of the piece.
- * @return A vector of valid (row, col) moves for the piece at @p start.
+ * @param out Receives the valid moves for the piece at @p start.
  */
-std::vector<std::pair<int, int>>
-IOhandler::getMoveCandidates(std::pair<int, int> start) {
-  std::vector<std::pair<int, int>> out;
-  int id = ChessBoard::findFigureIndex(checkMate.restrictions, start);
-
-  // Collect moves from attackCandidates and moveCandidates.
-  std::vector<std::pair<int, int>> attacks =
-      ch->getBoard()[start.first][start.second]->getAttackCandidates(false);
-  out.insert(out.end(), attacks.begin(), attacks.end());
-
-  std::vector<std::pair<int, int>> moves =
-      ch->getBoard()[start.first][start.second]->getMoveCandidates();
-  out.insert(out.end(), moves.begin(), moves.end());
-
-  // If the king is attacked and the piece is not a king, only allow moves that save the king.
-  if (checkMate.kingAttacked &&
-      ch->getBoard()[start.first][start.second]->getCode() != KING) {
-    out = ChessBoard::getOverlap(out, checkMate.saveKingPath);
-  }
-
-  // If there's a restriction on the piece (e.g., pinned), intersect with restricted moves.
-  if (id != -1 &&
-      ch->getBoard()[start.first][start.second]->getCode() != KING) {
-    out = ChessBoard::getOverlap(
-        out, checkMate.restrictions.at(id).unrestrictedPositions);
+void IOhandler::getMoveCandidates(std::pair<int, int> start, MoveList &out) {
+  // Legal moves of the piece's side, restricted by pins and checks, then only this piece's.
+  MoveList legalMoves;
+  ch->generateLegalMoves(ch->getPiece(start.first, start.second).isWhite(), legalMoves);
+
+  int from = start.first * BOARDSIZE + start.second;
+  for (PackedMove candidate : legalMoves) {
+    if (moveFrom(candidate) == from) {
+      out.push(from, moveTo(candidate));
+    }
   }
-
-  return out;
 }
 
 /**
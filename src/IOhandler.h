@@ -73,8 +73,9 @@ private:
   /**
    * @brief Attempts to perform a move based on the provided move string.
    * @param move String describing the move (e.g., "e2e4").
+   * @param deadline When the AI's move is due, if `move` is "enemy".
    */
-  void move(const std::string &move);
+  void move(const std::string &move, Deadline deadline = NO_DEADLINE);
 
   /**
    * @brief Retrieves a list of possible commands or moves at the current state.
@@ -91,9 +92,9 @@ private:
   /**
    * @brief Gets valid move candidates for a piece at the given starting coordinate.
    * @param start A pair (x, y) representing the starting position.
-   * @return A vector of (x, y) pairs representing valid move targets.
+   * @param out Receives the valid moves.
    */
-  std::vector<std::pair<int, int>> getMoveCandidates(std::pair<int, int> start);
+  void getMoveCandidates(std::pair<int, int> start, MoveList &out);
 
   /**
    * @brief Prints valid move candidates for a piece at the given starting coordinate.
@@ -101,11 +102,42 @@ private:
    */
   void printMoveCandidates(std::string start);
 
+  /**
+   * @brief Counts the leaf nodes of the move tree from the current position and prints
+   *        the count with the time taken and the nodes per second.
+   * @param args "<depth>" or "divide <depth>"; divide also prints the count below each move.
+   */
+  void printPerft(const std::string &args);
+
   /**
    * @brief Sets various parameters needed for the game setup or continuation.
    */
   void setParams();
 
+  /**
+   * @brief Selects the search engine of the AI.
+   * @param name "drunk" (or "beam") or "alphabeta".
+   */
+  void setEngine(const std::string &name);
+
+  /**
+   * @brief Resizes the transposition table shared by the searches.
+   * @param megabytes The new size in megabytes.
+   */
+  void setHashSize(const std::string &megabytes);
+
+  /**
+   * @brief Sets how many threads a search runs on.
+   * @param count The new thread count.
+   */
+  void setThreads(const std::string &count);
+
+  /**
+   * @brief Sets how many plies of captures the selected search follows past its last ply.
+   * @param plies The new ply count, 0 to follow none.
+   */
+  void setQuiescence(const std::string &plies);
+
   /**
    * @brief Prints the current state of the board to the output stream.
    */
@@ -123,6 +155,13 @@ private:
    */
   std::pair<int, int> transcodePosition(std::string str);
 
+  /**
+   * @brief The reverse of transcodePosition: board coordinates as the player types them.
+   * @param pos A pair (row, col) of board coordinates.
+   * @return The two-digit string for the current side.
+   */
+  std::string encodePosition(std::pair<int, int> pos);
+
 public:
   /**
    * @brief Converts the given string to lowercase.
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @file   chess-arena.h
+ * @brief  Stack-ordered scratch memory for the search.
+ */
+
+/**
+ * @class Arena
+ * @brief One preallocated block of T handed out in last-in, first-out frames.
+ *
+ * A search node takes a frame on entry and gives it back on exit, so a whole
+ * search thread runs on the single allocation made when it starts, and all of it
+ * is released at once when the thread is done. Threads never share an arena.
+ */
+template <typename T> class Arena {
+public:
+  /**
+   * @brief A frame of `count` slots, given back when it goes out of scope.
+   * @throws std::runtime_error if the arena has no room left.
+   */
+  class Frame {
+  public:
+    Frame(Arena &arena, size_t count) : arena(arena), saved(arena.used) {
+      if (arena.used + count > arena.slots.size()) {
+        throw std::runtime_error("OUT_OF_MEMORY");
+      }
+      data = arena.slots.data() + arena.used;
+      arena.used += count;
+    }
+
+    ~Frame() { arena.used = saved; }
+
+    Frame(const Frame &) = delete;
+    Frame &operator=(const Frame &) = delete;
+
+    T *data; ///< First slot of the frame.
+
+  private:
+    Arena &arena;
+    size_t saved;
+  };
+
+  /**
+   * @brief Allocates room for `capacity` elements up front.
+   */
+  explicit Arena(size_t capacity) : slots(capacity) {}
+
+private:
+  std::vector<T> slots;
+  size_t used = 0;
+};
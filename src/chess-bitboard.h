@@ -0,0 +1,253 @@
+#pragma once
+
+#include <cstdint>
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+/**
+ * @file   chess-bitboard.h
+ * @brief  64-bit square masks used by ChessBoard to answer attack queries.
+ *
+ * Square index is `row * 8 + col`, so bit 0 is (0, 0) and bit 63 is (7, 7).
+ * Rows and columns follow the board's own convention: board[row][col].
+ */
+
+/**
+ * @brief Ray directions. The order matches the `rotation` table used by
+ *        ChessBoard::evaluateCheckMate (north first, then clockwise).
+ */
+enum RayDirection {
+  NORTH,
+  NORTH_EAST,
+  EAST,
+  SOUTH_EAST,
+  SOUTH,
+  SOUTH_WEST,
+  WEST,
+  NORTH_WEST,
+};
+
+/**
+ * @brief Mask with every square set.
+ */
+const uint64_t ALL_SQUARES = ~0ULL;
+
+/**
+ * @brief Returns the square index for a (row, col) pair.
+ */
+constexpr int squareOf(int row, int col) { return row * 8 + col; }
+
+/**
+ * @brief Returns a mask with only the given square set.
+ */
+constexpr uint64_t squareBit(int square) { return 1ULL << square; }
+
+/**
+ * @brief Index of the least significant set bit. The mask must not be empty.
+ */
+inline int lowestSquare(uint64_t mask) { return __builtin_ctzll(mask); }
+
+/**
+ * @brief Index of the most significant set bit. The mask must not be empty.
+ */
+inline int highestSquare(uint64_t mask) { return 63 - __builtin_clzll(mask); }
+
+/**
+ * @brief Number of set bits in the mask.
+ */
+inline int countSquares(uint64_t mask) { return __builtin_popcountll(mask); }
+
+/**
+ * @brief True if moving along the direction increases the square index.
+ */
+inline bool isPositiveDirection(int direction) {
+  return direction == NORTH || direction == NORTH_EAST ||
+         direction == EAST || direction == NORTH_WEST;
+}
+
+/**
+ * @struct SliderMagic
+ * @brief Attack lookup of one slider type on one square.
+ *
+ * The occupancy of the relevant squares is turned into an index into the
+ * square's block of precomputed attack sets: with BMI2 by extracting those bits
+ * (PEXT), otherwise by a magic multiplication.
+ */
+struct SliderMagic {
+  uint64_t mask;            ///< Squares whose occupancy matters (ray ends excluded).
+  uint64_t magic;           ///< Multiplier hashing the masked occupancy, unused with PEXT.
+  const uint64_t *attacks;  ///< This square's block of attack sets.
+  int shift;                ///< 64 minus the number of squares in mask.
+
+  unsigned index(uint64_t occupancy) const {
+#ifdef __BMI2__
+    return unsigned(_pext_u64(occupancy, mask));
+#else
+    return unsigned(((occupancy & mask) * magic) >> shift);
+#endif
+  }
+};
+
+/**
+ * @struct StepTables
+ * @brief Masks that depend only on the square, generated at compile time.
+ */
+struct StepTables {
+  uint64_t rays[8][64];  ///< Squares from a square to the edge, per direction.
+  uint64_t knight[64];   ///< Knight jumps per square.
+  uint64_t king[64];     ///< Adjacent squares per square.
+  uint64_t pawn[2][64];  ///< Pawn captures per [white][square].
+};
+
+/**
+ * @brief Mask of (row, col) if it lies on the board, 0 otherwise.
+ */
+constexpr uint64_t stepBit(int row, int col) {
+  return row >= 0 && row < 8 && col >= 0 && col < 8 ? squareBit(squareOf(row, col)) : 0;
+}
+
+/**
+ * @brief Builds the StepTables; only ever evaluated by the compiler.
+ */
+constexpr StepTables makeStepTables() {
+  // Row and column step for each RayDirection
+  const int rayStep[8][2] = {
+      {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1},
+  };
+  const int knightStep[8][2] = {
+      {2, 1}, {2, -1}, {-2, 1}, {-2, -1}, {1, 2}, {1, -2}, {-1, 2}, {-1, -2},
+  };
+  StepTables tables{};
+
+  for (int row = 0; row < 8; ++row) {
+    for (int col = 0; col < 8; ++col) {
+      int square = squareOf(row, col);
+
+      for (int dir = 0; dir < 8; ++dir) {
+        for (int r = row + rayStep[dir][0], c = col + rayStep[dir][1];
+             stepBit(r, c); r += rayStep[dir][0], c += rayStep[dir][1]) {
+          tables.rays[dir][square] |= stepBit(r, c);
+        }
+        tables.king[square] |= stepBit(row + rayStep[dir][0], col + rayStep[dir][1]);
+        tables.knight[square] |= stepBit(row + knightStep[dir][0], col + knightStep[dir][1]);
+      }
+
+      tables.pawn[0][square] = stepBit(row - 1, col - 1) | stepBit(row - 1, col + 1);
+      tables.pawn[1][square] = stepBit(row + 1, col - 1) | stepBit(row + 1, col + 1);
+    }
+  }
+  return tables;
+}
+
+/**
+ * @brief Ray, knight, king and pawn masks. Constant data, nothing runs at startup.
+ */
+inline constexpr StepTables STEPS = makeStepTables();
+
+/**
+ * @struct BitboardTables
+ * @brief Slider lookup tables, filled once at static initialization.
+ */
+struct BitboardTables {
+  SliderMagic rookMagics[64];    ///< Rook lookup per square.
+  SliderMagic bishopMagics[64];  ///< Bishop lookup per square.
+  uint64_t rookTable[0x19000];   ///< Rook attack sets of all squares.
+  uint64_t bishopTable[0x1480];  ///< Bishop attack sets of all squares.
+
+  BitboardTables();
+};
+
+/**
+ * @brief The single instance of the slider lookup tables.
+ */
+extern const BitboardTables BITBOARDS;
+
+/**
+ * @brief All squares from (but excluding) `square` to the edge of the board.
+ */
+constexpr uint64_t rayMask(int direction, int square) {
+  return STEPS.rays[direction][square];
+}
+
+/**
+ * @brief Squares a slider standing on `square` reaches along one direction.
+ *        The first occupied square is included, everything behind it is not.
+ */
+inline uint64_t rayAttacks(int direction, int square, uint64_t occupancy) {
+  uint64_t attacks = rayMask(direction, square);
+  uint64_t blockers = attacks & occupancy;
+  if (blockers) {
+    int blocker = isPositiveDirection(direction) ? lowestSquare(blockers)
+                                                 : highestSquare(blockers);
+    attacks ^= rayMask(direction, blocker);
+  }
+  return attacks;
+}
+
+/**
+ * @brief Rook attacks from `square` for the given occupancy (one table lookup).
+ */
+inline uint64_t rookAttacks(int square, uint64_t occupancy) {
+  const SliderMagic &entry = BITBOARDS.rookMagics[square];
+  return entry.attacks[entry.index(occupancy)];
+}
+
+/**
+ * @brief Bishop attacks from `square` for the given occupancy (one table lookup).
+ */
+inline uint64_t bishopAttacks(int square, uint64_t occupancy) {
+  const SliderMagic &entry = BITBOARDS.bishopMagics[square];
+  return entry.attacks[entry.index(occupancy)];
+}
+
+/**
+ * @brief Queen attacks from `square` for the given occupancy.
+ */
+inline uint64_t queenAttacks(int square, uint64_t occupancy) {
+  return rookAttacks(square, occupancy) | bishopAttacks(square, occupancy);
+}
+
+/**
+ * @brief Squares a knight on `square` jumps to.
+ */
+constexpr uint64_t knightAttacks(int square) { return STEPS.knight[square]; }
+
+/**
+ * @brief Squares adjacent to `square` (king moves).
+ */
+constexpr uint64_t kingAttacks(int square) { return STEPS.king[square]; }
+
+/**
+ * @brief Squares a pawn of the given color on `square` attacks diagonally.
+ */
+constexpr uint64_t pawnAttacks(bool white, int square) {
+  return STEPS.pawn[white][square];
+}
+
+/**
+ * @brief Calls `visit(square)` for every square of `mask`, in ascending order
+ *        (row-major on the board).
+ */
+template <typename Visitor>
+inline void forEachSquare(uint64_t mask, Visitor visit) {
+  while (mask) {
+    int square = lowestSquare(mask);
+    mask &= mask - 1;
+    visit(square);
+  }
+}
+
+/**
+ * @brief Calls `visit(square)` for every square of `mask`, walking outwards
+ *        from the origin along `direction`. `mask` must lie on a single ray.
+ */
+template <typename Visitor>
+inline void forEachOnRay(int direction, uint64_t mask, Visitor visit) {
+  while (mask) {
+    int square = isPositiveDirection(direction) ? lowestSquare(mask)
+                                                : highestSquare(mask);
+    visit(square);
+    mask ^= squareBit(square);
+  }
+}
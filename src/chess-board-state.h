@@ -0,0 +1,87 @@
+#pragma once
+
+#include "chess-peice-codes.h"
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * @file   chess-board-state.h
+ * @brief  Plain value snapshot of a ChessBoard position.
+ *
+ * Everything that defines a position lives in one trivially copyable struct, so a
+ * whole board is copied or restored with a single assignment. Castling rights need
+ * no separate field: they follow from the moved flags of the kings and rooks.
+ */
+
+/**
+ * @brief Bit layout of one entry of BoardState::squares.
+ */
+enum SquareBits : uint8_t {
+  SQUARE_CODE = 0x07,  ///< ChessPieceCode of the occupant, EMPTY if none.
+  SQUARE_WHITE = 0x08, ///< Set for white pieces.
+  SQUARE_MOVED = 0x10, ///< Set once the piece has moved.
+};
+
+/**
+ * @brief Packs a square occupant into one byte.
+ */
+inline uint8_t encodeSquare(ChessPieceCode code, bool white, bool moved) {
+  return uint8_t(code) | (white ? SQUARE_WHITE : 0) | (moved ? SQUARE_MOVED : 0);
+}
+
+/**
+ * @brief The byte of a square without a piece.
+ */
+const uint8_t EMPTY_SQUARE = EMPTY;
+
+inline ChessPieceCode squareCode(uint8_t value) {
+  return ChessPieceCode(value & SQUARE_CODE);
+}
+
+inline bool squareWhite(uint8_t value) { return value & SQUARE_WHITE; }
+
+inline bool squareMoved(uint8_t value) { return value & SQUARE_MOVED; }
+
+/**
+ * @struct BoardState
+ * @brief Squares, last move and bitboards of a position.
+ */
+struct BoardState {
+  uint8_t squares[64];       ///< One encoded occupant per square, index row * 8 + col.
+  int8_t lastStart[2];       ///< (row, col) the last move started from, -1 if none.
+  int8_t lastEnd[2];         ///< (row, col) the last move ended on, -1 if none.
+  uint8_t lastCode;          ///< ChessPieceCode of the last moved piece.
+  bool lastFirstMove;        ///< LastMove::firstMove of the last move.
+  uint64_t pieceMasks[2][6]; ///< Squares per [white][piece code], KING..PAWN.
+  uint64_t colorMasks[2];    ///< Squares occupied by each color, [white].
+  uint64_t attackMaps[2];    ///< Squares attacked by each color, [white]; see ChessBoard::getAttackMap.
+  bool attackMapsValid;      ///< False once a square changed after attackMaps were built.
+  uint64_t key;              ///< Zobrist key of squares and en passant state, see ChessBoard::getKey.
+};
+
+static_assert(std::is_trivially_copyable<BoardState>::value,
+              "BoardState must stay copyable with memcpy");
+
+/**
+ * @struct UndoRecord
+ * @brief What ChessBoard::makeMove changed, so that unmakeMove can put it back.
+ *
+ * Every square the move wrote is kept with its byte from before the move. That
+ * covers the captured piece, the moved flag, the castling rook, a pawn taken en
+ * passant and the promoted pawn alike. The attack maps are saved whole, so the
+ * position left behind does not have to rebuild them.
+ */
+struct UndoRecord {
+  static constexpr int CAPACITY = 8; ///< Castling, the largest move, writes four squares.
+
+  int8_t lastStart[2];        ///< BoardState::lastStart before the move.
+  int8_t lastEnd[2];          ///< BoardState::lastEnd before the move.
+  uint8_t lastCode;           ///< BoardState::lastCode before the move.
+  bool lastFirstMove;         ///< BoardState::lastFirstMove before the move.
+  uint64_t attackMaps[2];     ///< BoardState::attackMaps before the move.
+  bool attackMapsValid;       ///< BoardState::attackMapsValid before the move.
+  uint64_t key;               ///< BoardState::key before the move.
+  uint8_t count;              ///< Number of squares written.
+  uint8_t squares[CAPACITY];  ///< Squares in the order they were written.
+  uint8_t before[CAPACITY];   ///< Their bytes before the first write.
+};
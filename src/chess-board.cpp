@@ -1,7 +1,13 @@
 #include "chess-board.h"
 #include "IOhandler.h"
+#include "chess-search.h"
+#include "chess-thread-pool.h"
+#include "chess-transposition.h"
 #include <algorithm>
+#include <atomic>
+#include <future>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <set>
 #include <sstream>
@@ -12,78 +18,97 @@
 static int debugCounter = 0;
 
 /**
- * @brief Returns the overlapping positions from two vectors of positions.
+ * @brief Keeps only the moves whose destination appears in 'positions'.
  */
-std::vector<std::pair<int, int>> ChessBoard::getOverlap(
-    const std::vector<std::pair<int, int>>& positions1,
-    const std::vector<std::pair<int, int>>& positions2
+void ChessBoard::getOverlap(
+    MoveList& moves,
+    const std::vector<std::pair<int, int>>& positions
 ) {
-    std::vector<std::pair<int, int>> overlap;
-    for (const auto& pos : positions1) {
-        if (std::find(positions2.begin(), positions2.end(), pos) != positions2.end()) {
-            overlap.push_back(pos);
-        }
-    }
-    return overlap;
+    moves.filter([&](PackedMove move) {
+        std::pair<int, int> pos = {moveTo(move) / BOARDSIZE, moveTo(move) % BOARDSIZE};
+        return std::find(positions.begin(), positions.end(), pos) != positions.end();
+    });
 }
 
 /**
- * @brief Create a chess piece on the heap given its parameters.
+ * @brief Write one square of the state, keeping the bitboards in step.
  * @throws std::runtime_error if the code is invalid.
  */
-ChessPieceBase* ChessBoard::createPeice(
-    int x, int y, bool color, ChessPieceCode code, Logger* log,
-    ChessBoard *board, bool moved_
-) {
-    switch (code) {
-    case KING:
-        return new ChessPeiceKing(x, y, color, log, board, moved_);
-    case QUEEN:
-        return new ChessPieceQueen(x, y, color, log, board, moved_);
-    case BISHOP:
-        return new ChessPieceBishop(x, y, color, log, board, moved_);
-    case KNIGHT:
-        return new ChessPieceKnight(x, y, color, log, board, moved_);
-    case ROOK:
-        return new ChessPieceRook(x, y, color, log, board, moved_);
-    case PAWN:
-        return new ChessPiecePawn(x, y, color, log, board, moved_);
-    case EMPTY:
-        return new ChessPieceEmpty(x, y, log, board);
-    default:
+void ChessBoard::setSquare(int row, int col, uint8_t value) {
+    if (squareCode(value) > EMPTY) {
         throw std::runtime_error("UNKNOWN OPTION");
     }
-}
 
-ChessPieceBase*** ChessPieceBase::getBoard() { return chessBoard->getBoard(); }
+    int square = squareOf(row, col);
+    uint8_t old = state.squares[square];
+    uint64_t bit = squareBit(square);
+    if (recording) {
+        if (recording->count == UndoRecord::CAPACITY) {
+            throw std::logic_error("UNDO RECORD OVERFLOW");
+        }
+        recording->squares[recording->count] = square;
+        recording->before[recording->count] = old;
+        recording->count++;
+    }
+    if (squareCode(old) != EMPTY) {
+        state.pieceMasks[squareWhite(old)][squareCode(old)] &= ~bit;
+        state.colorMasks[squareWhite(old)] &= ~bit;
+    }
+    if (squareCode(value) != EMPTY) {
+        state.pieceMasks[squareWhite(value)][squareCode(value)] |= bit;
+        state.colorMasks[squareWhite(value)] |= bit;
+    }
 
+    state.key ^= ZOBRIST.squares[old][square] ^ ZOBRIST.squares[value][square];
+    state.squares[square] = value;
+    if (old != value) {
+        state.attackMapsValid = false;
+    }
+}
 
 /**
- * @brief Create a chess piece from a single-character code (e.g., 'K', 'Q', etc.).
- * @throws std::runtime_error if the code is invalid.
+ * @brief Rebuild the attack maps of both colors from the bitboards.
+ *
+ * Same rules as the original square-by-square check: kings neither attack nor
+ * block rays, pawns attack both forward diagonals.
  */
-ChessPieceBase* ChessBoard::createPeiceFromString(
-    int x, int y, bool color, char code, Logger* log,
-    ChessBoard * board, bool moved_
-) {
-    switch (code) {
-    case 'K':
-        return new ChessPeiceKing(x, y, color, log, board, moved_);
-    case 'Q':
-        return new ChessPieceQueen(x, y, color, log, board, moved_);
-    case 'B':
-        return new ChessPieceBishop(x, y, color, log, board, moved_);
-    case 'H':
-        return new ChessPieceKnight(x, y, color, log, board, moved_);
-    case 'R':
-        return new ChessPieceRook(x, y, color, log, board, moved_);
-    case 'P':
-        return new ChessPiecePawn(x, y, color, log, board, moved_);
-    case '0':
-        return new ChessPieceEmpty(x, y, log, board);
-    default:
-        throw std::runtime_error("UNKNOWN OPTION");
+void ChessBoard::buildAttackMaps() {
+    uint64_t occupancy = getOccupancy() & ~getPieceMask(true, KING) & ~getPieceMask(false, KING);
+    for (int white = 0; white < 2; ++white) {
+        uint64_t attacks = 0;
+        uint64_t queens = getPieceMask(white, QUEEN);
+
+        forEachSquare(getPieceMask(white, KNIGHT), [&](int square) {
+            attacks |= knightAttacks(square);
+        });
+        forEachSquare(getPieceMask(white, PAWN), [&](int square) {
+            attacks |= pawnAttacks(white, square);
+        });
+        forEachSquare(getPieceMask(white, ROOK) | queens, [&](int square) {
+            attacks |= rookAttacks(square, occupancy);
+        });
+        forEachSquare(getPieceMask(white, BISHOP) | queens, [&](int square) {
+            attacks |= bishopAttacks(square, occupancy);
+        });
+        state.attackMaps[white] = attacks;
     }
+    state.attackMapsValid = true;
+}
+
+/**
+ * @brief Empty every square and forget the last move.
+ */
+void ChessBoard::resetState() {
+    state = BoardState{};
+    std::fill(state.squares, state.squares + BOARDSIZE * BOARDSIZE, EMPTY_SQUARE);
+    setLastMove({{{-1, -1}, {-1, -1}}, NONE, false});
+}
+
+/**
+ * @brief Replace the position with `snapshot`.
+ */
+void ChessBoard::loadState(const BoardState& snapshot) {
+    state = snapshot;
 }
 
 /**
@@ -94,19 +119,17 @@ ChessPieceBase* ChessBoard::createPeiceFromString(
  * @return A set of coordinates that are threatened by the given color.
  */
 std::set<std::pair<int, int>> ChessBoard::getDangerousPoints(
-    ChessPieceBase*** board, bool white
+    ChessBoard* board, bool white
 ) {
+    uint64_t danger = 0;
+    board->forEachPiece(!white, [&](int /*square*/, const ChessPiece& piece) {
+        danger |= piece.getAttackMask(true);
+    });
+
     std::set<std::pair<int, int>> dangerousPoints;
-    for (int i = 0; i < BOARDSIZE; ++i) {
-        for (int j = 0; j < BOARDSIZE; ++j) {
-            if (board[i][j]->isPlayable() && board[i][j]->isWhite() != white) {
-                auto attackCandidates = board[i][j]->getAttackCandidates(true);
-                for (const auto& candidate : attackCandidates) {
-                    dangerousPoints.insert(candidate);
-                }
-            }
-        }
-    }
+    forEachSquare(danger, [&](int square) {
+        dangerousPoints.insert({square / BOARDSIZE, square % BOARDSIZE});
+    });
     return dangerousPoints;
 }
 
@@ -135,7 +158,7 @@ void ChessBoard::debugPrintDanger() {
     std::cout << std::endl << std::endl << std::endl;
 
     for (int k = 0; k < 2; k++) {
-        auto danger = ChessBoard::getDangerousPoints(board, k);
+        auto danger = ChessBoard::getDangerousPoints(this, k);
         for (int i = 0; i < 8; i++) {
             for (int j = 0; j < 8; j++) {
                 if (danger.find({i, j}) != danger.end()) {
@@ -158,19 +181,18 @@ void ChessBoard::debugPrintDanger() {
  */
 ChessBoard::ChessBoard(Logger* log, int difficulty)
     : log(log), difficulty(difficulty) {
-    board = new ChessPieceBase**[BOARDSIZE];
-
-    // Initialize Black's first and pawn rows
-    board[7] = createFirstRow(false);
-    board[6] = createPawnRow(false);
-
-    // Initialize White's first and pawn rows
-    board[0] = createFirstRow(true);
-    board[1] = createPawnRow(true);
-
-    // Fill remaining rows with empty squares
-    for (int i = 2; i < 6; i++) {
-        board[i] = createEmptyRow(i);
+    static const ChessPieceCode firstRow[BOARDSIZE] = {
+        ROOK, KNIGHT, BISHOP, QUEEN, KING, BISHOP, KNIGHT, ROOK
+    };
+
+    resetState();
+
+    // White's first and pawn rows, then Black's
+    for (int col = 0; col < BOARDSIZE; ++col) {
+        setSquare(0, col, encodeSquare(firstRow[col], true, false));
+        setSquare(1, col, encodeSquare(PAWN, true, false));
+        setSquare(6, col, encodeSquare(PAWN, false, false));
+        setSquare(7, col, encodeSquare(firstRow[col], false, false));
     }
 
     if (log != nullptr) {
@@ -183,62 +205,18 @@ ChessBoard::ChessBoard(ChessBoard* board)
     if(!board) throw std::runtime_error("BOARD PROVIDED WAS NULLPTR");
     this->difficulty = board->getDifficulty();
     this->log = nullptr;
-    this->board = copyBoard(board,this);
-}
-
-
-
-/**
- * @brief Create an empty row of chess pieces (all are EMPTY).
- */
-ChessPieceBase** ChessBoard::createEmptyRow(int row) {
-    ChessPieceBase** rowArray = new ChessPieceBase*[BOARDSIZE];
-    for (int i = 0; i < BOARDSIZE; i++) {
-        rowArray[i] = new ChessPieceEmpty(i, row, log, this);
-    }
-    return rowArray;
-}
-
-/**
- * @brief Create the first (major) row for a given color (Rook, Knight, Bishop, Queen, King, ...).
- */
-ChessPieceBase** ChessBoard::createFirstRow(bool white) {
-    ChessPieceBase** rowArray = new ChessPieceBase*[BOARDSIZE];
-    int y = white ? 0 : 7;
-
-    rowArray[0] = new ChessPieceRook(0, y, white, log, this);
-    rowArray[1] = new ChessPieceKnight(1, y, white, log, this);
-    rowArray[2] = new ChessPieceBishop(2, y, white, log, this);
-    rowArray[3] = new ChessPieceQueen(3, y, white, log, this);
-    rowArray[4] = new ChessPeiceKing(4, y, white, log, this);
-    rowArray[5] = new ChessPieceBishop(5, y, white, log, this);
-    rowArray[6] = new ChessPieceKnight(6, y, white, log, this);
-    rowArray[7] = new ChessPieceRook(7, y, white, log, this);
-
-    return rowArray;
-}
-
-/**
- * @brief Create the pawn row for a given color.
- */
-ChessPieceBase** ChessBoard::createPawnRow(bool white) {
-    ChessPieceBase** rowArray = new ChessPieceBase*[BOARDSIZE];
-    int y = white ? 1 : 6;
-    for (int i = 0; i < BOARDSIZE; i++) {
-        rowArray[i] = new ChessPiecePawn(i, y, white, log, this);
-    }
-    return rowArray;
+    this->state = board->state;
 }
 
 /**
  * @brief Print a given board to an output stream (used internally).
  */
 void ChessBoard::printImaginaryBoard(
-    ChessPieceBase*** board, std::ostream* out
+    ChessBoard* board, std::ostream* out
 ) {
     for (int i = 7; i >= 0; --i) {
         for (int j = 0; j < 8; j++) {
-            *out << board[i][j]->print() << ' ';
+            *out << board->getPiece(i, j).print() << ' ';
         }
         *out << std::endl;
     }
@@ -264,7 +242,7 @@ void ChessBoard::printBoard(bool white, std::ostream* out, bool server) {
              (white ? (col < BOARDSIZE) : (col >= 0));
              (white ? col++ : col--))
         {
-            *out << board[row][col]->print() << ' ';
+            *out << getPiece(row, col).print() << ' ';
         }
         if (!server) {
             *out << std::endl;
@@ -276,31 +254,44 @@ void ChessBoard::printBoard(bool white, std::ostream* out, bool server) {
 }
 
 /**
- * @brief Clear the board (delete all pieces and replace them with EMPTY).
+ * @brief Clear the board (replace all pieces with EMPTY).
  */
 void ChessBoard::clear() {
     for (int i = 0; i < BOARDSIZE; ++i) {
         for (int j = 0; j < BOARDSIZE; ++j) {
-            if (board[i][j] != nullptr) {
-                delete board[i][j];
-            }
+            setSquare(i, j, EMPTY_SQUARE);
         }
-        delete[] board[i];
-        board[i] = createEmptyRow(i);
     }
 }
 
 /**
- * @brief Thread function to help calculate move scores in parallel.
+ * @brief Slots a node needs for its candidates: the list holds at most
+ *        max(difficulty, 1) entries and never more than a node has moves,
+ *        plus one while an insertion is pending.
+ */
+static size_t candidateFrameSize(int difficulty) {
+    return std::min(std::max(difficulty, 1), MoveList::CAPACITY) + 1;
+}
+
+/**
+ * @brief Task body: plays the candidate on a copy of the root and searches the reply.
  */
 void ChessBoard::threadFunc(Thread_Parameter* param) {
+    // One frame per depth, the difficulty dropping by one on every level
+    size_t capacity = 0;
+    for (int depth = 1; depth <= param->maxDepth; ++depth) {
+        capacity += candidateFrameSize(param->difficulty - (depth - 1));
+    }
+    CandidateArena arena(capacity);
+
+    ChessBoard board(param->board);
+    board.performMove(param->move, nullptr, true);
     param->score = worth * recursiveSubroutine(
-        param->board, !param->white,
+        &board, !param->white,
         param->difficulty, 1,
-        param->maxDepth, worth * worth
+        param->maxDepth, worth * worth, arena,
+        param->deadline
     );
-    delete param->board;
-    param->ready = true;
 }
 
 /**
@@ -318,26 +309,18 @@ void ChessBoard::makeBoardFromString(const std::string& str) {
     std::string buf;
 
     // Clean up the old board
-    deleteBoard(this->board);
-    board = new ChessPieceBase**[BOARDSIZE];
-    if (!board) {
-        throw std::runtime_error("OUT_OF_MEMORY");
-    }
-
-    for (int r = 0; r < BOARDSIZE; ++r) {
-        board[r] = new ChessPieceBase*[BOARDSIZE];
-        if (!board[r]) {
-            throw std::runtime_error("OUT_OF_MEMORY");
-        }
-    }
+    clear();
 
     // Fill board with given data
     while (counter != 64 && iss >> buf) {
         int k = std::stoi(buf);
         counter++;
-        board[i][j] = createPeiceFromString(
-            j, i, (k & 0b10), char(k >> 3), this->log, this, (k & 0b1)
-        );
+        ChessPieceCode code = ChessPieceBase::getPieceCode(char(k >> 3));
+        if (code == NONE) {
+            throw std::runtime_error("UNKNOWN OPTION");
+        }
+        setSquare(i, j, code == EMPTY ? EMPTY_SQUARE
+                                      : encodeSquare(code, (k & 0b10), (k & 0b1)));
         j++;
         if (j == BOARDSIZE) {
             i++;
@@ -362,115 +345,138 @@ void ChessBoard::makeBoardFromString(const std::string& str) {
 }
 
 /**
- * @brief Finds the best move for a given side using a simplified search.
- *        This function spawns threads for deeper analysis if difficulty is high enough.
+ * @brief Finds the best move for a given side with the selected searchEngine.
  *
  * @param white The color for which we are searching (true = white, false = black).
+ * @param deadline When the move is due; see the declaration.
  * @return A Move object containing the best move found.
  * @throws std::runtime_error if no move is possible.
  */
-Move ChessBoard::getBestMove(bool white) {
-    int maxDepth = (difficulty < 6) ? difficulty : (difficulty / 2);
-    std::vector<std::thread> threads;
-    std::vector<Thread_Parameter*> params;
+Move ChessBoard::getBestMove(bool white, Deadline deadline) {
+    int maxDepth = getSearchDepth();
+    transpositionTable.newSearch();
+    if (searchEngine == ALPHA_BETA) {
+        return getAlphaBetaMove(white, maxDepth, deadline);
+    }
+    return getBeamMove(white, maxDepth, deadline).move;
+}
+
+/**
+ * @brief The beam: the best `difficulty` 1-ply candidates, each valued by
+ *        recursiveSubroutine below it on the thread pool.
+ */
+Move_Candidate ChessBoard::getBeamMove(bool white, int maxDepth, Deadline deadline) {
     std::vector<Move_Candidate> topCandidates;
-    float maxScore = 0.0f;
     int bestIndex = 0;
 
+    // Moves that fall back to makeMove are scored on a copy, the game board stays untouched
     ChessBoard* tempBoard = new ChessBoard(this);
     if (!tempBoard) {
         throw std::runtime_error("OUT_OF_MEMORY");
     }
 
-    // Evaluate if the king is in check
-    Special_Parameter checkMate = evaluateCheckMate(white, tempBoard->board);
-
     // Gather move candidates
-    for (int i = 0; i < BOARDSIZE; ++i) {
-        for (int j = 0; j < BOARDSIZE; ++j) {
-            if (board[i][j]->isWhite() == white) {
-                // Attack candidates + move candidates
-                auto candidates = board[i][j]->getAttackCandidates(false);
-                auto moveCandidates = board[i][j]->getMoveCandidates();
-                candidates.insert(candidates.end(), moveCandidates.begin(), moveCandidates.end());
-
-                int restrictionIndex = findFigureIndex(checkMate.restrictions, {i, j});
-                // If king is attacked or if there's a move restriction on this piece
-                if ((checkMate.kingAttacked || restrictionIndex != -1) &&
-                    board[i][j]->getCode() != KING)
-                {
-                    candidates = filterMoves(candidates, checkMate, restrictionIndex);
-                }
+    MoveList candidates;
+    generateLegalMoves(white, candidates);
 
-                // Evaluate each candidate quickly (just 1-ply)
-                for (auto& endPos : candidates) {
-                    revertBoard(tempBoard, this);
-                    tempBoard->setLastMove(lastmove);
-                    float dScore = tempBoard->performMove({{i, j}, endPos}, nullptr, true);
-
-                    // Insert or shift in the top candidates list
-                    if (topCandidates.empty()) {
-                        topCandidates.push_back({{ {i, j}, endPos }, dScore});
-                    } else {
-                        bool inserted = false;
-                        for (int k = 0; k < (int)topCandidates.size(); ++k) {
-                            if (topCandidates[k].dScore < dScore) {
-                                topCandidates.insert(
-                                    topCandidates.begin() + k,
-                                    {{ {i, j}, endPos }, dScore}
-                                );
-                                inserted = true;
-                                if ((int)topCandidates.size() > difficulty) {
-                                    topCandidates.pop_back();
-                                }
-                                break;
-                            }
-                        }
-                        if (!inserted && (int)topCandidates.size() < difficulty) {
-                            topCandidates.push_back({{{i, j}, endPos}, dScore});
-                        }
+    // Evaluate each candidate quickly (just 1-ply)
+    for (PackedMove candidate : candidates) {
+        Move move = unpackMove(candidate);
+        float dScore = tempBoard->scoreMove(move);
+
+        // Insert or shift in the top candidates list
+        if (topCandidates.empty()) {
+            topCandidates.push_back({move, dScore});
+        } else {
+            bool inserted = false;
+            for (int k = 0; k < (int)topCandidates.size(); ++k) {
+                if (topCandidates[k].dScore < dScore) {
+                    topCandidates.insert(topCandidates.begin() + k, {move, dScore});
+                    inserted = true;
+                    if ((int)topCandidates.size() > difficulty) {
+                        topCandidates.pop_back();
                     }
+                    break;
                 }
             }
+            if (!inserted && (int)topCandidates.size() < difficulty) {
+                topCandidates.push_back({move, dScore});
+            }
         }
     }
+    delete tempBoard;
 
-    // Spawn threads for deeper analysis on top candidates if maxDepth > 0
-    for (int i = 0; i < (int)topCandidates.size() && maxDepth > 0; ++i) {
-        auto* param = new Thread_Parameter;
-        if (!param) {
-            throw std::runtime_error("OUT_OF_MEMORY");
-        }
-
-        param->board = new ChessBoard(this);
-        if (!param->board) {
-            throw std::runtime_error("OUT_OF_MEMORY");
-        }
-        param->score = topCandidates[i].dScore;
-        param->board->performMove(topCandidates[i].move, nullptr, true);
-        param->difficulty = difficulty;
-        param->maxDepth = maxDepth;
-        param->white = white;
-        param->ready = false;
-
-        if (log) {
-            log->log("THREAD " + std::to_string(i) + " STARTED");
+    if (topCandidates.empty()) {
+        // No moves found
+        return {{{-1, -1}, {-1, -1}}, 0.0f};
+    }
+    float bestScore = topCandidates[0].dScore;
+
+    // Without a deadline only the full depth is searched. With one, every depth
+    // is, each iteration filling the transposition table for the next; the best
+    // 1-ply candidate stands until the first iteration finishes.
+    int firstDepth = (deadline == NO_DEADLINE) ? maxDepth : 1;
+    for (int depth = firstDepth; depth <= maxDepth && depth > 0; ++depth) {
+        int index;
+        float score;
+        if (!runBeamIteration(white, topCandidates, depth, deadline, index, score)) {
+            if (log) {
+                log->log("DEADLINE REACHED AT DEPTH " + std::to_string(depth));
+            }
+            break;
         }
+        bestIndex = index;
+        bestScore = score;
+    }
+    return {topCandidates[bestIndex].move, bestScore};
+}
 
-        params.push_back(param);
-        threads.emplace_back(std::thread{threadFunc, param});
-        threads.back().detach();
+/**
+ * @brief Evaluates the root candidates as tasks of the thread pool, the calling
+ *        thread helping, and collects them in candidate order. As the tasks share
+ *        the transposition table, a position one has expanded is looked up by the
+ *        others. A finished iteration is told from a cut one by the clock: once
+ *        the deadline has passed, some candidate may have scored an unsearched 0.
+ *        An exception of a candidate is rethrown here once every task is done.
+ */
+bool ChessBoard::runBeamIteration(bool white, const std::vector<Move_Candidate>& topCandidates,
+                                  int maxDepth, Deadline deadline, int& bestIndex,
+                                  float& bestScore) {
+    int count = (int)topCandidates.size();
+    std::vector<Thread_Parameter> params(count);
+    for (int i = 0; i < count; ++i) {
+        params[i] = {this, topCandidates[i].move, white, difficulty, maxDepth, 0.0f, deadline};
     }
 
-    // Collect results from threads
-    for (int i = 0; i < (int)topCandidates.size() && maxDepth > 0; ++i) {
-        while (!params[i]->ready) {
-            std::this_thread::yield();
+    std::vector<std::future<void>> tasks;
+    for (Thread_Parameter& param : params) {
+        tasks.push_back(threadPool.submit([&param]() { threadFunc(&param); }));
+    }
+    // Every task has to be done before params goes, so the first error waits
+    std::exception_ptr error;
+    for (std::future<void>& task : tasks) {
+        try {
+            threadPool.wait(task);
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
         }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    if (log) {
+        log->log("BEAM DEPTH " + std::to_string(maxDepth) + " ON " +
+                 std::to_string(threadPool.getThreads()) + " THREADS");
+    }
 
-        float finalScore = topCandidates[i].dScore - params[i]->score;
+    float maxScore = 0.0f;
+    bestIndex = 0;
+    for (int i = 0; i < count; ++i) {
+        float finalScore = topCandidates[i].dScore - params[i].score;
         if (log) {
-            log->log("THREAD " + std::to_string(i) + " FINISHED WITH SCORE: " + std::to_string(finalScore));
+            log->log("CANDIDATE " + std::to_string(i) + " SCORED " + std::to_string(finalScore));
         }
 
         if (i == 0) {
@@ -484,19 +490,67 @@ Move ChessBoard::getBestMove(bool white) {
         }
     }
 
-    // Clean up
-    for (int i = 0; i < (int)topCandidates.size() && maxDepth > 0; ++i) {
-        delete params[i];
+    bestScore = maxScore;
+    return !deadlinePassed(deadline);
+}
+
+/**
+ * @brief getBestMove of the ALPHA_BETA engine: searches a copy of the board with
+ *        as many nodes as the beam would spend at this difficulty, and at least
+ *        one ply deeper than the beam looks, however many nodes that takes. A Lazy SMP
+ *        helper per worker of the thread pool searches a copy of its own
+ *        alongside until the main search is done.
+ */
+Move ChessBoard::getAlphaBetaMove(bool white, int maxDepth, Deadline deadline) {
+    MoveList rootMoves;
+    generateLegalMoves(white, rootMoves);
+    uint64_t budget = AlphaBetaSearch::beamNodeBudget(
+        difficulty, maxDepth, std::max(rootMoves.size(), 1));
+
+    std::atomic<bool> stop{false};
+    std::vector<std::future<void>> helpers;
+    for (int i = 1; i < threadPool.getThreads(); ++i) {
+        helpers.push_back(threadPool.submit([this, white, budget, &stop, i]() {
+            ChessBoard helperBoard(this);
+            AlphaBetaSearch helper(&helperBoard, budget);
+            helper.makeHelper(&stop, i);
+            try {
+                helper.findBestMove(white);
+            } catch (...) {
+                // The main search meets the same position and reports it
+            }
+        }));
     }
-    params.clear();
-    threads.clear();
-    delete tempBoard;
+    auto joinHelpers = [&stop, &helpers]() {
+        stop = true;
+        for (std::future<void>& helper : helpers) {
+            threadPool.wait(helper);
+        }
+    };
+
+    ChessBoard searchBoard(this);
+    AlphaBetaSearch search(&searchBoard, budget, deadline, maxDepth + 1);
+    Move best;
+    try {
+        best = search.findBestMove(white);
+    } catch (...) {
+        joinHelpers();
+        throw;
+    }
+    joinHelpers();
 
-    if (topCandidates.empty()) {
-        // No moves found
-        return {{-1, -1}, {-1, -1}};
+    if (log) {
+        std::string line;
+        for (const Move& move : search.getPrincipalVariation()) {
+            line += " " + Logger::moveToString(move);
+        }
+        log->log("ALPHA-BETA DEPTH " + std::to_string(search.getCompletedDepth()) +
+                 " NODES " + std::to_string(search.getNodes()) +
+                 " OF " + std::to_string(budget) +
+                 " SCORE " + std::to_string(search.getCompletedScore()) +
+                 " PV" + line);
     }
-    return topCandidates[bestIndex].move;
+    return best;
 }
 
 /**
@@ -511,154 +565,215 @@ ChessPieceCode ChessBoard::askReplacement(bool side, IOhandler* handler) {
 }
 
 /**
- * @brief Filter a set of moves based on current check/checkmate constraints.
+ * @brief Filter a list of moves in place based on current check/checkmate constraints.
  */
-std::vector<std::pair<int, int>> ChessBoard::filterMoves(
-    const std::vector<std::pair<int, int>>& input,
-    Special_Parameter checkMate, int usedIndex
+void ChessBoard::filterMoves(
+    MoveList& moves,
+    const Special_Parameter& checkMate, int usedIndex
 ) {
-    std::vector<std::pair<int, int>> filteredMoves;
-    std::vector<std::pair<int, int>> validPositions;
-
     if (usedIndex < (int)checkMate.restrictions.size() && usedIndex != -1) {
+        // The piece may only stay on its pin line
+        getOverlap(moves, checkMate.restrictions[usedIndex].unrestrictedPositions);
         // If king is attacked, we only allow moves that can save the king
         if (checkMate.kingAttacked) {
-            for (const auto& pos : checkMate.restrictions[usedIndex].unrestrictedPositions) {
-                if (std::find(checkMate.saveKingPath.begin(),
-                              checkMate.saveKingPath.end(),
-                              pos) != checkMate.saveKingPath.end()) {
-                    validPositions.push_back(pos);
-                }
-            }
-        } else {
-            validPositions = checkMate.restrictions[usedIndex].unrestrictedPositions;
+            getOverlap(moves, checkMate.saveKingPath);
         }
     } else {
         // No restrictions for the piece, but king might be attacked
-        validPositions = checkMate.saveKingPath;
+        getOverlap(moves, checkMate.saveKingPath);
     }
+}
 
-    // Keep only the moves that are in the validPositions
-    for (const auto& move : input) {
-        if (std::find(validPositions.begin(), validPositions.end(), move) != validPositions.end()) {
-            filteredMoves.push_back(move);
-        }
+/**
+ * @brief Collect every legal move of one color, square by square in row-major order.
+ *        Per piece, captures come before quiet moves. Pieces other than the king only
+ *        generate moves onto their pin line and, in check, onto the save path.
+ */
+void ChessBoard::generateLegalMoves(bool white, MoveList& out, Check_Masks* check) {
+    Check_Masks local;
+    Check_Masks& masks = check ? *check : local;
+    evaluateCheckMasks(white, this, masks);
+
+    if (white) {
+        appendLegalMoves<true>(out, masks);
+    } else {
+        appendLegalMoves<false>(out, masks);
+    }
+}
+
+/**
+ * @brief generateLegalMoves for the color `White`, once the check masks are known.
+ */
+template <bool White>
+void ChessBoard::appendLegalMoves(MoveList& out, const Check_Masks& masks) {
+    // In double check the save path is empty and only the king is left to move
+    uint64_t allowed = masks.kingAttacked ? masks.saveKingPath : ALL_SQUARES;
+    if (!allowed) {
+        forEachSquare(getPieceMask(White, KING), [&](int square) {
+            ChessPieceBase::getAttackCandidates<White, false>(this, square, out, ALL_SQUARES);
+            ChessPieceBase::getMoveCandidates<White>(this, square, out, ALL_SQUARES);
+        });
+        return;
     }
 
-    return filteredMoves;
+    uint64_t kings = getPieceMask(White, KING);
+    forEachSquare(getColorMask(White), [&](int square) {
+        uint64_t targets = ALL_SQUARES;
+        if (!(kings & squareBit(square))) {
+            targets = allowed;
+            if (masks.pinned & squareBit(square)) {
+                for (int i = 0; i < masks.pinCount; ++i) {
+                    if (masks.pinSquares[i] == square) {
+                        targets &= masks.pinPaths[i];
+                        break;
+                    }
+                }
+            }
+            if (!targets) {
+                return;
+            }
+        }
+
+        ChessPieceBase::getAttackCandidates<White, false>(this, square, out, targets);
+        ChessPieceBase::getMoveCandidates<White>(this, square, out, targets);
+    });
+}
+
+/**
+ * @brief Transposition table key of a beam node. Its value depends on the position,
+ *        the beam width and the plies left, so the latter two salt the position key.
+ */
+static uint64_t beamKey(ChessBoard* chessBoard, bool white, int difficulty, int remaining) {
+    uint64_t salt = (uint64_t(uint32_t(difficulty)) << 8) ^ uint64_t(uint8_t(remaining));
+    return chessBoard->getKey(white) ^ splitMix64(salt);
 }
 
 /**
  * @brief Recursive subroutine to evaluate board positions up to a certain depth.
  *        It uses a minimax-like approach with limited branching.
+ *        Results are shared with all threads and later moves through the
+ *        transposition table, so a position reached again is not expanded again.
  */
 const float ChessBoard::recursiveSubroutine(
     ChessBoard* chessBoard, bool white,
-    int difficulty, int depth, int maxDepth, float worth
+    int difficulty, int depth, int maxDepth, float worth,
+    CandidateArena& arena, Deadline deadline
 ) {
-    ChessBoard* tempBoard = new ChessBoard(chessBoard);
-    if (!tempBoard) {
-        throw std::runtime_error("OUT_OF_MEMORY");
+    uint64_t key = beamKey(chessBoard, white, difficulty, maxDepth - depth);
+    TT_Entry cached;
+    if (transpositionTable.probe(key, cached) && cached.bound == TT_EXACT) {
+        return cached.score;
+    }
+    if (deadlinePassed(deadline)) {
+        return 0.0f;
     }
 
-    ChessPieceBase*** board = chessBoard->getBoard();
-    Special_Parameter checkMate = evaluateCheckMate(white, tempBoard->board);
-    std::vector<Move_Candidate> topCandidates;
+    float score = expandBeamNode(chessBoard, white, difficulty, depth, maxDepth, worth, arena,
+                                 deadline);
+    // A node cut by the deadline may hold unsearched scores; keep it out of the table
+    if (!deadlinePassed(deadline)) {
+        transpositionTable.store(key, maxDepth - depth, TT_EXACT, score, 0);
+    }
+    return score;
+}
+
+/**
+ * @brief The work of recursiveSubroutine for a position not in the table.
+ *        Candidates are made and unmade on 'chessBoard' itself, which is left as it was found.
+ */
+float ChessBoard::expandBeamNode(
+    ChessBoard* chessBoard, bool white,
+    int difficulty, int depth, int maxDepth, float worth,
+    CandidateArena& arena, Deadline deadline
+) {
+    // At the horizon the position is valued by its best immediate score and,
+    // if the beam is set to follow them, the captures after it
+    if (depth == maxDepth) {
+        float infinity = std::numeric_limits<float>::infinity();
+        return chessBoard->quiescence(white, -infinity, infinity, quiescencePlies[BEAM]);
+    }
+
+    Check_Masks checkMate;
+    CandidateArena::Frame frame(arena, candidateFrameSize(difficulty));
+    Move_Candidate* topCandidates = frame.data;
+    int count = 0;
 
     // Collect all moves for 'white'
-    for (int i = 0; i < BOARDSIZE; ++i) {
-        for (int j = 0; j < BOARDSIZE; ++j) {
-            if (board[i][j]->isWhite() == white) {
-                auto candidates = board[i][j]->getAttackCandidates(false);
-                auto moves = board[i][j]->getMoveCandidates();
-                candidates.insert(candidates.end(), moves.begin(), moves.end());
-
-                int restrictionIndex = findFigureIndex(checkMate.restrictions, {i, j});
-                if ((checkMate.kingAttacked || restrictionIndex != -1) &&
-                    board[i][j]->getCode() != KING)
-                {
-                    candidates = filterMoves(candidates, checkMate, restrictionIndex);
-                }
+    MoveList candidates;
+    chessBoard->generateLegalMoves(white, candidates, &checkMate);
 
-                // 1-ply evaluation
-                for (const auto& endPos : candidates) {
-                    revertBoard(tempBoard, chessBoard);
-                    tempBoard->lastmove = chessBoard->lastmove;
-                    float score = tempBoard->performMove({{i, j}, endPos}, nullptr, true);
-
-                    if (topCandidates.empty()) {
-                        topCandidates.push_back({{{i, j}, endPos}, score});
-                    } else {
-                        bool inserted = false;
-                        for (int k = 0; k < (int)topCandidates.size(); ++k) {
-                            if (topCandidates[k].dScore < score) {
-                                topCandidates.insert(
-                                    topCandidates.begin() + k,
-                                    {{{i, j}, endPos}, score}
-                                );
-                                inserted = true;
-                                if ((int)topCandidates.size() > difficulty) {
-                                    topCandidates.pop_back();
-                                }
-                                break;
-                            }
-                        }
-                        if (!inserted && (int)topCandidates.size() < difficulty) {
-                            topCandidates.push_back({{{i, j}, endPos}, score});
-                        }
+    // 1-ply evaluation
+    for (PackedMove candidate : candidates) {
+        Move move = unpackMove(candidate);
+        float score = chessBoard->scoreMove(move);
+
+        if (count == 0) {
+            topCandidates[count++] = {move, score};
+        } else {
+            bool inserted = false;
+            for (int k = 0; k < count; ++k) {
+                if (topCandidates[k].dScore < score) {
+                    std::copy_backward(topCandidates + k, topCandidates + count,
+                                       topCandidates + count + 1);
+                    topCandidates[k] = {move, score};
+                    inserted = true;
+                    if (++count > difficulty) {
+                        --count;
                     }
+                    break;
                 }
             }
+            if (!inserted && count < difficulty) {
+                topCandidates[count++] = {move, score};
+            }
         }
     }
 
-    // If maximum depth is reached, just return the best immediate score
-    if (depth == maxDepth) {
-        delete tempBoard;
-        if (!topCandidates.empty()) {
-            return topCandidates.front().dScore; // best immediate move
-        } else if (checkMate.kingAttacked) {
+    // We proceed deeper
+    float maxScore = 0.0f;
+    bool firstEval = true;
+
+    for (int i = 0; i < count; ++i) {
+        UndoRecord undo;
+        chessBoard->makeMove(topCandidates[i].move, undo);
+
+        // Minimax-like approach: subtract the opponent's best response
+        float dScore = topCandidates[i].dScore -
+                       recursiveSubroutine(
+                           chessBoard, !white, difficulty - 1,
+                           depth + 1, maxDepth, worth * worth, arena,
+                           deadline
+                       );
+        chessBoard->unmakeMove(undo);
+
+        if (firstEval) {
+            maxScore = dScore;
+            firstEval = false;
+        } else if (dScore > maxScore) {
+            maxScore = dScore;
+        }
+    }
+
+    if (count == 0) {
+        // No moves found
+        if (checkMate.kingAttacked) {
             return Mate;
         } else {
             return Pate;
         }
-    } else {
-        // We proceed deeper
-        float maxScore = 0.0f;
-        bool firstEval = true;
-
-        for (int i = 0; i < (int)topCandidates.size(); ++i) {
-            revertBoard(tempBoard, chessBoard);
-            tempBoard->lastmove = chessBoard->lastmove;
-            tempBoard->performMove(topCandidates[i].move, nullptr, true);
-
-            // Minimax-like approach: subtract the opponent's best response
-            float dScore = topCandidates[i].dScore -
-                           recursiveSubroutine(
-                               tempBoard, !white, difficulty - 1,
-                               depth + 1, maxDepth, worth * worth
-                           );
-
-            if (firstEval) {
-                maxScore = dScore;
-                firstEval = false;
-            } else if (dScore > maxScore) {
-                maxScore = dScore;
-            }
-        }
-
-        delete tempBoard;
-
-        if (topCandidates.empty()) {
-            // No moves found
-            if (checkMate.kingAttacked) {
-                return Mate;
-            } else {
-                return Pate;
-            }
-        }
-        return maxScore;
     }
+    return maxScore;
+}
+
+/**
+ * @brief score + price * ATTACK_COST, the product and the sum rounded each on its
+ *        own as the original did. Every threat term of a move's score goes
+ *        through here, so a move scored without being made (scoreMove) rounds
+ *        exactly as one that is made; the file is built without contraction, so
+ *        no target fuses the two.
+ */
+static inline float threatened(float score, int price) {
+    return score + float(price) * ATTACK_COST;
 }
 
 /**
@@ -676,14 +791,10 @@ float ChessBoard::performMove(
     const Move& move,
     IOhandler* handler, bool overrideRightess
 ) {
-    if (!board) {
-        throw std::logic_error("Board is null");
-    }
-
     // You cannot attack the king directly
-    if (board[move.end.first][move.end.second]->getCode() == KING &&
-        board[move.start.first][move.start.second]->isWhite() !=
-        board[move.end.first][move.end.second]->isWhite())
+    if (getPiece(move.end.first, move.end.second).getCode() == KING &&
+        getPiece(move.start.first, move.start.second).isWhite() !=
+        getPiece(move.end.first, move.end.second).isWhite())
     {
         throw std::runtime_error("CANNOT ATTACK KING");
     }
@@ -693,17 +804,17 @@ float ChessBoard::performMove(
 
     if (overrideRightess) {
         // Simplified logic for forced move
-        isAttack = (board[move.start.first][move.start.second]->isWhite() !=
-                    board[move.end.first][move.end.second]->isWhite()) &&
-                   (board[move.end.first][move.end.second]->getCode() != EMPTY);
+        isAttack = (getPiece(move.start.first, move.start.second).isWhite() !=
+                    getPiece(move.end.first, move.end.second).isWhite()) &&
+                   (getPiece(move.end.first, move.end.second).getCode() != EMPTY);
 
         // The code snippet seems to check for castling condition if the piece at
         // end is a rook. This might be incomplete or specialized logic.
         canMove = (!isAttack ||
-                   board[move.end.first][move.end.second]->getCode() == ROOK);
+                   getPiece(move.end.first, move.end.second).getCode() == ROOK);
     } else {
-        isAttack = board[move.start.first][move.start.second]->canAttack(move.end);
-        canMove = board[move.start.first][move.start.second]->canMoveTo(move.end);
+        isAttack = getPiece(move.start.first, move.start.second).canAttack(move.end);
+        canMove = getPiece(move.start.first, move.start.second).canMoveTo(move.end);
     }
 
     if (isAttack) {
@@ -711,7 +822,7 @@ float ChessBoard::performMove(
         return performAttack(move, handler);
     } else if (canMove) {
         // If the destination is a rook and certain conditions hold, it's castling
-        if (board[move.end.first][move.end.second]->getCode() == ROOK) {
+        if (getPiece(move.end.first, move.end.second).getCode() == ROOK) {
             return performCastling(move, handler);
         } else {
             return performNormalMove(move, handler);
@@ -721,6 +832,186 @@ float ChessBoard::performMove(
     throw std::logic_error("CAN'T MOVE");
 }
 
+/**
+ * @brief Perform a forced move while recording every square it writes into 'undo'.
+ */
+float ChessBoard::makeMove(const Move& move, UndoRecord& undo) {
+    std::copy(state.lastStart, state.lastStart + 2, undo.lastStart);
+    std::copy(state.lastEnd, state.lastEnd + 2, undo.lastEnd);
+    undo.lastCode = state.lastCode;
+    undo.lastFirstMove = state.lastFirstMove;
+    std::copy(state.attackMaps, state.attackMaps + 2, undo.attackMaps);
+    undo.attackMapsValid = state.attackMapsValid;
+    undo.key = state.key;
+    undo.count = 0;
+
+    recording = &undo;
+    try {
+        float score = performMove(move, nullptr, true);
+        recording = nullptr;
+        return score;
+    } catch (...) {
+        recording = nullptr;
+        unmakeMove(undo);
+        throw;
+    }
+}
+
+/**
+ * @brief performAttack and performNormalMove done on paper. The threat terms
+ *        come in the order getAttackCandidates gives them and round through
+ *        threatened, as they do when the move is made.
+ */
+float ChessBoard::scoreMove(const Move& move) {
+    int from = squareOf(move.start.first, move.start.second);
+    int to = squareOf(move.end.first, move.end.second);
+    uint8_t mover = state.squares[from];
+    uint8_t target = state.squares[to];
+    ChessPieceCode code = squareCode(mover);
+    ChessPieceCode targetCode = squareCode(target);
+    bool white = squareWhite(mover);
+    bool promotes = (code == PAWN && move.end.first == 7 * white);
+
+    if (targetCode != EMPTY && white != squareWhite(target)) {
+        if (targetCode == KING) {
+            throw std::runtime_error("CANNOT ATTACK KING");
+        }
+        // performAttack
+        float score = getScore(targetCode);
+        if (!squareMoved(mover) && code != KING && code != ROOK) {
+            score += FirstMove;
+        }
+        if (promotes) {
+            return score + getScore(QUEEN);
+        }
+        return score;
+    }
+
+    // Castling, swaps with an own piece, king steps and promotions are made
+    if (targetCode != EMPTY || code == KING || code == EMPTY || promotes) {
+        UndoRecord undo;
+        float score = makeMove(move, undo);
+        unmakeMove(undo);
+        return score;
+    }
+
+    // performNormalMove: threats given up on the start square, taken on the end square
+    uint64_t occupancy = getOccupancy();
+    uint64_t enemies = getColorMask(!white);
+    float score = 0.0f;
+    MoveList threats;
+    ChessPieceBase::appendAttackOrder(
+        code, from, ChessPieceBase::getThreatMask(code, white, from, occupancy, enemies), threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, -getScore(squareCode(state.squares[moveTo(threat)])));
+    }
+
+    if (!squareMoved(mover) && code != ROOK) {
+        score += FirstMove;
+    }
+
+    uint64_t after = occupancy ^ squareBit(from) ^ squareBit(to);
+    threats.clear();
+    ChessPieceBase::appendAttackOrder(
+        code, to, ChessPieceBase::getThreatMask(code, white, to, after, enemies), threats);
+    for (PackedMove threat : threats) {
+        // The start square is empty after the move
+        int square = moveTo(threat);
+        score = threatened(score, getScore(square == from ? EMPTY : squareCode(state.squares[square])));
+    }
+    return score;
+}
+
+/**
+ * @brief Quiet moves are scored in place and give the stand-pat score; captures
+ *        are then made in MVV-LVA order while they can still raise it.
+ */
+float ChessBoard::quiescence(bool white, float alpha, float beta, int plies,
+                             PackedMove* bestMove) {
+    Check_Masks check;
+    MoveList moves;
+    generateLegalMoves(white, moves, &check);
+    if (bestMove) {
+        *bestMove = 0;
+    }
+    if (moves.empty()) {
+        return check.kingAttacked ? Mate : Pate;
+    }
+
+    float best = -std::numeric_limits<float>::infinity();
+    PackedMove bestPacked = 0;
+    MoveList captures;
+    for (PackedMove packed : moves) {
+        uint8_t target = state.squares[moveTo(packed)];
+        if (plies > 0 && squareCode(target) != EMPTY && squareWhite(target) != white) {
+            captures.push(moveFrom(packed), moveTo(packed));
+            continue;
+        }
+        float score = scoreMove(unpackMove(packed));
+        if (score > best) {
+            best = score;
+            bestPacked = packed;
+            if (best >= beta) {
+                break;
+            }
+        }
+    }
+
+    if (best < beta && !captures.empty()) {
+        alpha = std::max(alpha, best);
+        // Most valuable victim first, least valuable attacker among equal victims
+        captures.sort([this](PackedMove a, PackedMove b) {
+            int victimA = getScore(squareCode(state.squares[moveTo(a)]));
+            int victimB = getScore(squareCode(state.squares[moveTo(b)]));
+            if (victimA != victimB) {
+                return victimA > victimB;
+            }
+            return getScore(squareCode(state.squares[moveFrom(a)])) <
+                   getScore(squareCode(state.squares[moveFrom(b)]));
+        });
+
+        for (PackedMove packed : captures) {
+            UndoRecord undo;
+            float dScore = makeMove(unpackMove(packed), undo);
+            // Our value is dScore - reply; keep the reply's window in step with ours
+            float value = dScore - quiescence(!white, dScore - beta, dScore - alpha, plies - 1);
+            unmakeMove(undo);
+
+            if (value > best) {
+                best = value;
+                bestPacked = packed;
+                if (best > alpha) {
+                    alpha = best;
+                    if (alpha >= beta) {
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    if (bestMove) {
+        *bestMove = bestPacked;
+    }
+    return best;
+}
+
+/**
+ * @brief Take back a move made by makeMove, newest write first.
+ */
+void ChessBoard::unmakeMove(const UndoRecord& undo) {
+    for (int i = undo.count - 1; i >= 0; --i) {
+        setSquare(undo.squares[i] / BOARDSIZE, undo.squares[i] % BOARDSIZE, undo.before[i]);
+    }
+    std::copy(undo.lastStart, undo.lastStart + 2, state.lastStart);
+    std::copy(undo.lastEnd, undo.lastEnd + 2, state.lastEnd);
+    state.lastCode = undo.lastCode;
+    state.lastFirstMove = undo.lastFirstMove;
+    std::copy(undo.attackMaps, undo.attackMaps + 2, state.attackMaps);
+    state.attackMapsValid = undo.attackMapsValid;
+    state.key = undo.key;
+}
+
 /**
  * @brief Perform an attack move.
  *
@@ -729,57 +1020,33 @@ float ChessBoard::performMove(
 float ChessBoard::performAttack(
     const Move& move, IOhandler* handler
 ) {
-    lastmove.code = board[move.start.first][move.start.second]->getCode();
-    lastmove.start = move.start;
-    lastmove.end = move.end;
-    lastmove.firstMove = !board[move.start.first][move.start.second]->getCode();
-    float score = getScore(board[move.end.first][move.end.second]->getCode());
+    uint8_t mover = state.squares[squareOf(move.start.first, move.start.second)];
+    setLastMove({move, squareCode(mover), !squareCode(mover)});
+    float score = getScore(getPiece(move.end.first, move.end.second).getCode());
 
     // Bonus for certain first moves (like a first pawn move?)
-    if (!board[move.start.first][move.start.second]->hasMoved() &&
-        board[move.start.first][move.start.second]->getCode() != KING &&
-        board[move.start.first][move.start.second]->getCode() != ROOK)
+    if (!getPiece(move.start.first, move.start.second).hasMoved() &&
+        getPiece(move.start.first, move.start.second).getCode() != KING &&
+        getPiece(move.start.first, move.start.second).getCode() != ROOK)
     {
         score += FirstMove;
     }
 
     // Pawn promotion check
-    if (board[move.start.first][move.start.second]->getCode() == PAWN &&
-        move.end.first == (7 * board[move.start.first][move.start.second]->isWhite()))
+    if (squareCode(mover) == PAWN &&
+        move.end.first == (7 * squareWhite(mover)))
     {
-        ChessPieceCode promotionCode = askReplacement(
-            board[move.start.first][move.start.second]->isWhite(), handler
-        );
-        ChessPieceBase* newPiece = createPeice(
-            move.end.second, move.end.first,
-            board[move.start.first][move.start.second]->isWhite(),
-            promotionCode,
-            board[move.start.first][move.start.second]->getLogger(),
-            this, true
-        );
-
-        delete board[move.start.first][move.start.second];
-        delete board[move.end.first][move.end.second];
-        board[move.end.first][move.end.second] = newPiece;
-
-        board[move.start.first][move.start.second] = new ChessPieceEmpty(
-            move.start.second, move.start.first,
-            newPiece->getLogger(), this
-        );
+        ChessPieceCode promotionCode = askReplacement(squareWhite(mover), handler);
+        setSquare(move.end.first, move.end.second,
+                  encodeSquare(promotionCode, squareWhite(mover), true));
+        setSquare(move.start.first, move.start.second, EMPTY_SQUARE);
 
         return score + getScore(promotionCode);
     }
 
     // Perform the capture
-    delete board[move.end.first][move.end.second];
-    board[move.end.first][move.end.second] =
-        board[move.start.first][move.start.second];
-    board[move.end.first][move.end.second]->move(move.end);
-
-    board[move.start.first][move.start.second] = new ChessPieceEmpty(
-        move.start.second, move.start.first,
-        board[move.end.first][move.end.second]->getLogger(), this
-    );
+    setSquare(move.end.first, move.end.second, mover | SQUARE_MOVED);
+    setSquare(move.start.first, move.start.second, EMPTY_SQUARE);
 
     return score;
 }
@@ -792,90 +1059,67 @@ float ChessBoard::performNormalMove(
     IOhandler* handler
 ) {
     float score = 0.0f;
-    lastmove.code = board[move.start.first][move.start.second]->getCode();
-    lastmove.start = move.start;
-    lastmove.end = move.end;
-    lastmove.firstMove = !board[move.start.first][move.start.second]->getCode();
+    uint8_t mover = state.squares[squareOf(move.start.first, move.start.second)];
+    setLastMove({move, squareCode(mover), !squareCode(mover)});
     // Subtract cost for leaving squares that might be attacking opponents
     // (a heuristic).
-    for (const auto& coord :
-         board[move.start.first][move.start.second]->getAttackCandidates(true))
-    {
-        score -= getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+    MoveList threats;
+    getPiece(move.start.first, move.start.second).getAttackCandidates(true, threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, -getScore(getPiece(moveTo(threat)).getCode()));
     }
 
-    if (!board[move.start.first][move.start.second]->hasMoved() &&
-        board[move.start.first][move.start.second]->getCode() != KING &&
-        board[move.start.first][move.start.second]->getCode() != ROOK)
+    if (!getPiece(move.start.first, move.start.second).hasMoved() &&
+        getPiece(move.start.first, move.start.second).getCode() != KING &&
+        getPiece(move.start.first, move.start.second).getCode() != ROOK)
     {
         score += FirstMove;
     }
 
     // Pawn promotion check
-    if (board[move.start.first][move.start.second]->getCode() == PAWN &&
-        move.end.first == (7 * board[move.start.first][move.start.second]->isWhite()))
+    if (squareCode(mover) == PAWN &&
+        move.end.first == (7 * squareWhite(mover)))
     {
-        ChessPieceCode promotionCode = askReplacement(
-            board[move.start.first][move.start.second]->isWhite(), handler
-        );
-        ChessPieceBase* newPiece = createPeice(
-            move.end.second, move.end.first,
-            board[move.start.first][move.start.second]->isWhite(),
-            promotionCode,
-            board[move.start.first][move.start.second]->getLogger(),
-            this, true
-        );
-
-        delete board[move.start.first][move.start.second];
-        board[move.start.first][move.start.second] = new ChessPieceEmpty(
-            move.start.second, move.start.first, newPiece->getLogger(), this
-        );
-        board[move.end.first][move.end.second] = newPiece;
+        ChessPieceCode promotionCode = askReplacement(squareWhite(mover), handler);
+        setSquare(move.start.first, move.start.second, EMPTY_SQUARE);
+        setSquare(move.end.first, move.end.second,
+                  encodeSquare(promotionCode, squareWhite(mover), true));
 
         // Add cost for new squares threatened
-        for (const auto& coord : newPiece->getAttackCandidates(true)) {
-            score += getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+        MoveList threats;
+        getPiece(move.end.first, move.end.second).getAttackCandidates(true, threats);
+        for (PackedMove threat : threats) {
+            score = threatened(score, getScore(getPiece(moveTo(threat)).getCode()));
         }
         return score + getScore(promotionCode);
     }
 
     // En passant
+    LastMove lastmove = getLastMove();
     if(lastmove.code == PAWN)
     {
-        if(board[move.end.first][move.end.second]->getCode() == EMPTY)
+        if(getPiece(move.end.first, move.end.second).getCode() == EMPTY)
         {
             if( lastmove.firstMove &&
                 lastmove.end.second == move.end.second &&
                 abs(lastmove.end.first - lastmove.start.first) == 2)
                 {
-                    ChessPieceBase* newPiece = createPeice(
-                        lastmove.end.second, lastmove.end.first,
-                        false,
-                        EMPTY,
-                        board[lastmove.start.first][lastmove.start.second]->getLogger(),
-                        this, true
-                    );
-                    delete board[lastmove.end.first][lastmove.end.second];
-                    board[lastmove.end.first][lastmove.end.second] = newPiece;
+                    setSquare(lastmove.end.first, lastmove.end.second, EMPTY_SQUARE);
                     score += getScore(PAWN);
                 }
         }
     }
 
-    // Perform the normal move
-    ChessPieceBase* tempPiece = board[move.end.first][move.end.second];
-    board[move.end.first][move.end.second] =
-        board[move.start.first][move.start.second];
-    board[move.end.first][move.end.second]->move(move.end);
-    board[move.start.first][move.start.second] = tempPiece;
-
-
+    // Perform the normal move; whatever stood on the destination takes the start square
+    uint8_t target = state.squares[squareOf(move.end.first, move.end.second)];
+    setSquare(move.end.first, move.end.second, mover | SQUARE_MOVED);
+    setSquare(move.start.first, move.start.second, target);
 
     // Add cost for new squares threatened
-    for (const auto& coord :
-         board[move.end.first][move.end.second]->getAttackCandidates(true))
-    {
-        score += getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+    threats.clear();
+    getPiece(move.end.first, move.end.second).getAttackCandidates(true, threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, getScore(getPiece(moveTo(threat)).getCode()));
     }
 
     return score;
@@ -890,15 +1134,15 @@ float ChessBoard::performCastling(
     float score = 0.0f;
 
     // Subtract cost for leaving squares that might be attacking opponents
-    for (const auto& coord :
-         board[move.start.first][move.start.second]->getAttackCandidates(true))
-    {
-        score -= getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+    MoveList threats;
+    getPiece(move.start.first, move.start.second).getAttackCandidates(true, threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, -getScore(getPiece(moveTo(threat)).getCode()));
     }
-    for (const auto& coord :
-         board[move.end.first][move.end.second]->getAttackCandidates(true))
-    {
-        score -= getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+    threats.clear();
+    getPiece(move.end.first, move.end.second).getAttackCandidates(true, threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, -getScore(getPiece(moveTo(threat)).getCode()));
     }
 
     // Determine where the King and Rook should end up
@@ -932,20 +1176,17 @@ float ChessBoard::performCastling(
 
     // Move the King
     performMove({move.start, kingDestination}, handler, true);
-    lastmove.code = NONE;
-    lastmove.start = {-1,-1};
-    lastmove.end = {-1,-1};
-    lastmove.firstMove = false;
+    setLastMove({{{-1, -1}, {-1, -1}}, NONE, false});
     // Add new threatened squares cost
-    for (const auto& coord :
-         board[kingDestination.first][kingDestination.second]->getAttackCandidates(true))
-    {
-        score += getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+    threats.clear();
+    getPiece(kingDestination.first, kingDestination.second).getAttackCandidates(true, threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, getScore(getPiece(moveTo(threat)).getCode()));
     }
-    for (const auto& coord :
-         board[rookDestination.first][rookDestination.second]->getAttackCandidates(true))
-    {
-        score += getScore(board[coord.first][coord.second]->getCode()) * ATTACK_COST;
+    threats.clear();
+    getPiece(rookDestination.first, rookDestination.second).getAttackCandidates(true, threats);
+    for (PackedMove threat : threats) {
+        score = threatened(score, getScore(getPiece(moveTo(threat)).getCode()));
     }
 
     score += Castling;
@@ -953,56 +1194,8 @@ float ChessBoard::performCastling(
 }
 
 /**
- * @brief Create a copy of the board (dynamically allocated).
- *        If notImaginary is false, logger pointers will be set to null.
- */
-ChessPieceBase*** ChessBoard::copyBoard(
-    ChessBoard* chessBoardOld, ChessBoard* chessBoardNew,
-     bool notImaginary
-) {
-    ChessPieceBase*** board = chessBoardOld->getBoard();
-    if (!board) {
-        return nullptr;
-    }
-
-    ChessPieceBase*** newBoard = new ChessPieceBase**[BOARDSIZE];
-    if (!newBoard) {
-        return nullptr;
-    }
-
-    for (int i = 0; i < BOARDSIZE; ++i) {
-        newBoard[i] = new ChessPieceBase*[BOARDSIZE];
-        if (!newBoard[i]) {
-            return nullptr;
-        }
-
-        for (int j = 0; j < BOARDSIZE; ++j) {
-            if (board[i][j]) {
-                ChessPieceBase* pieceCopy = ChessBoard::createPeice(
-                    board[i][j]->getX(),
-                    board[i][j]->getY(),
-                    board[i][j]->isWhite(),
-                    board[i][j]->getCode(),
-                    (Logger*)((size_t)board[i][j]->getLogger() * notImaginary),
-                    chessBoardNew,
-                    board[i][j]->hasMoved()
-                );
-                if (!pieceCopy) {
-                    return nullptr;
-                }
-                newBoard[i][j] = pieceCopy;
-            } else {
-                return nullptr;
-            }
-        }
-    }
-    return newBoard;
-}
-
-
-/**
- * @brief Revert the 'imaginaryBoard' to match 'board'.
- *        This effectively copies board's state into imaginaryBoard's state.
+ * @brief Copy the position of 'board' into 'imaginaryBoard'.
+ *        A single state copy.
  */
 void ChessBoard::revertBoard(
     ChessBoard* imaginaryBoard,
@@ -1011,56 +1204,7 @@ void ChessBoard::revertBoard(
     if (!board || !imaginaryBoard) {
         throw std::runtime_error("CRITICAL ERROR, IMPOSSIBLE TO REVERT BOARD");
     }
-
-    for (int i = 0; i < BOARDSIZE; ++i) {
-        if (!board->board[i] || !imaginaryBoard->board[i]) {
-            throw std::runtime_error("CRITICAL ERROR, IMPOSSIBLE TO REVERT BOARD");
-        }
-        for (int j = 0; j < BOARDSIZE; ++j) {
-            if (!board->board[i][j]) {
-                throw std::runtime_error("CRITICAL ERROR, IMPOSSIBLE TO REVERT BOARD");
-            }
-            ChessPieceBase* pieceCopy = ChessBoard::createPeice(
-                board->board[i][j]->getX(),
-                board->board[i][j]->getY(),
-                board->board[i][j]->isWhite(),
-                board->board[i][j]->getCode(),
-                nullptr,
-                imaginaryBoard,
-                board->board[i][j]->hasMoved()
-            );
-            if (!pieceCopy) {
-                throw std::runtime_error(
-                    "CRITICAL ERROR, IMPOSSIBLE TO REVERT BOARD"
-                );
-            }
-            delete imaginaryBoard->board[i][j];
-            imaginaryBoard->board[i][j] = pieceCopy;
-        }
-    }
-}
-
-/**
- * @brief Delete and free the entire board array.
- */
-ChessPieceBase*** ChessBoard::deleteBoard(
-    ChessPieceBase*** board
-) {
-    if (!board) {
-        return nullptr;
-    }
-    for (int i = 0; i < BOARDSIZE; ++i) {
-        if (board[i]) {
-            for (int j = 0; j < BOARDSIZE; ++j) {
-                if (board[i][j]) {
-                    delete board[i][j];
-                }
-            }
-            delete[] board[i];
-        }
-    }
-    delete[] board;
-    return nullptr;
+    imaginaryBoard->loadState(board->state);
 }
 
 /**
@@ -1072,21 +1216,13 @@ void ChessBoard::cycleFigure(std::pair<int, int> pos, bool color, ChessPieceCode
     if (pos.first >= 0 && pos.second >= 0 &&
         pos.first < BOARDSIZE && pos.second < BOARDSIZE)
     {
-        if (!board[pos.first][pos.second]) {
-            board[pos.first][pos.second] =
-                createPeice(pos.second, pos.first, color, code, log, this);
-            return;
-        }
-
-        ChessPieceCode existingCode = board[pos.first][pos.second]->getCode();
-        delete board[pos.first][pos.second];
+        ChessPieceCode existingCode = getPiece(pos.first, pos.second).getCode();
 
         if (existingCode == EMPTY) {
-            board[pos.first][pos.second] =
-                createPeice(pos.second, pos.first, color, code, log, this);
+            setSquare(pos.first, pos.second,
+                      code == EMPTY ? EMPTY_SQUARE : encodeSquare(code, color, false));
         } else {
-            board[pos.first][pos.second] =
-                createPeice(pos.second, pos.first, color, EMPTY, log, this);
+            setSquare(pos.first, pos.second, EMPTY_SQUARE);
         }
     }
 }
@@ -1095,15 +1231,14 @@ void ChessBoard::cycleFigure(std::pair<int, int> pos, bool color, ChessPieceCode
  * @brief Find the position of the king for a given color.
  * @throws std::logic_error if the king is not found.
  */
-std::pair<int, int> ChessBoard::findKing(bool side, ChessPieceBase*** board) {
+std::pair<int, int> ChessBoard::findKing(bool side, ChessBoard* board) {
+    // Columns are scanned first; within a column white looks upwards and black downwards.
+    uint64_t kings = board->getPieceMask(side, KING);
     for (int i = 0; i < BOARDSIZE; ++i) {
-        for (int j = (side ? 0 : 7);
-             (side ? (j < BOARDSIZE) : (j >= 0));
-             (side ? j++ : j--))
-        {
-            if (board[j][i]->getCode() == KING && board[j][i]->isWhite() == side) {
-                return {j, i};
-            }
+        uint64_t column = kings & (0x0101010101010101ULL << i);
+        if (column) {
+            int square = side ? lowestSquare(column) : highestSquare(column);
+            return {square / BOARDSIZE, square % BOARDSIZE};
         }
     }
     throw std::logic_error("NO KING WAS FOUND");
@@ -1114,17 +1249,16 @@ std::pair<int, int> ChessBoard::findKing(bool side, ChessPieceBase*** board) {
  */
 bool ChessBoard::isDangerous(
     int distance,
-    std::pair<int, int> kingPos,
     int8_t dX, int8_t dY,
-    ChessPieceBase* suspect
+    const ChessPiece& suspect
 ) {
-    ChessPieceCode code = suspect->getCode();
+    ChessPieceCode code = suspect.getCode();
 
     // Pawn check
     if (distance == 0 && code == PAWN) {
         // Pawn attacks one square diagonally
         return (dX != 0) &&
-               (dY == (1 - 2 * suspect->isWhite()));
+               (dY == (1 - 2 * suspect.isWhite()));
     }
 
     // Bishop/Queen check for diagonals
@@ -1143,157 +1277,119 @@ bool ChessBoard::isDangerous(
 bool ChessBoard::simplifiedEvaluateCheckMate(
     bool side,
     std::pair<int, int> kingPosition,
-    ChessPieceBase*** board
+    ChessBoard* board
 ) {
-    const int8_t rotation[10] = {0, 1, 1, 1, 0, -1, -1, -1, 0, 1};
-    const int8_t shift = 2;
+    // Knights, pawns, rooks, bishops and queens; kings do not block the rays here
+    return board->isSquareAttacked(!side, squareOf(kingPosition.first, kingPosition.second));
+}
 
-    // Check for knights in L-shaped positions
-    for (int j = -2; j <= 2; j += 4) {
-        for (int i = -1; i <= 1; i += 2) {
-            int x = kingPosition.second + j;
-            int y = kingPosition.first + i;
-            if (x >= 0 && x < BOARDSIZE && y >= 0 && y < BOARDSIZE) {
-                if (board[y][x]->getCode() == KNIGHT &&
-                    board[y][x]->isWhite() != side)
-                {
-                    return true;
-                }
-            }
+/**
+ * @brief Converts a mask into a list of positions in ascending square order.
+ */
+static std::vector<std::pair<int, int>> maskToPositions(uint64_t mask) {
+    std::vector<std::pair<int, int>> positions;
+    forEachSquare(mask, [&](int square) {
+        positions.push_back({square / BOARDSIZE, square % BOARDSIZE});
+    });
+    return positions;
+}
 
-            x = kingPosition.second + i;
-            y = kingPosition.first + j;
-            if (x >= 0 && x < BOARDSIZE && y >= 0 && y < BOARDSIZE) {
-                if (board[y][x]->getCode() == KNIGHT &&
-                    board[y][x]->isWhite() != side)
-                {
-                    return true;
-                }
-            }
-        }
-    }
+/**
+ * @brief Full evaluation if king is under check or checkmate, returning info about which pieces can save it, etc.
+ */
+Special_Parameter ChessBoard::evaluateCheckMate(
+    bool side,
+    ChessBoard* board
+) {
+    Check_Masks masks;
+    evaluateCheckMasks(side, board, masks);
 
-    // Check for rooks, bishops, queens
-    for (int c = 0; c < 8; ++c) {
-        int dist = 0;
-        int x = kingPosition.second + rotation[c];
-        int y = kingPosition.first + rotation[c + shift];
-        while (x < BOARDSIZE && y < BOARDSIZE && x >= 0 && y >= 0) {
-            ChessPieceBase* candidate = board[y][x];
-            if (candidate->getCode() != EMPTY && candidate->getCode() != KING) {
-                if (candidate->isWhite() != side) {
-                    if (isDangerous(dist, kingPosition, rotation[c], rotation[c + shift], candidate)) {
-                        return true;
-                    } else {
-                        break;
-                    }
-                } else {
-                    break;
-                }
-            }
-            dist++;
-            x += rotation[c];
-            y += rotation[c + shift];
-        }
+    Special_Parameter result{masks.kingAttacked, maskToPositions(masks.saveKingPath), {}};
+    for (int i = 0; i < masks.pinCount; ++i) {
+        int pinned = masks.pinSquares[i];
+        result.restrictions.push_back({{pinned / BOARDSIZE, pinned % BOARDSIZE}, maskToPositions(masks.pinPaths[i])});
     }
-    return false;
+    return result;
 }
 
 /**
- * @brief Full evaluation if king is under check or checkmate, returning info about which pieces can save it, etc.
+ * @brief Check and pin scan behind evaluateCheckMate, kept in bitboard form for the move generator.
  */
-Special_Parameter ChessBoard::evaluateCheckMate(
+void ChessBoard::evaluateCheckMasks(
     bool side,
-    ChessPieceBase*** board
+    ChessBoard* board,
+    Check_Masks& check
 ) {
     const int8_t rotation[10] = {0, 1, 1, 1, 0, -1, -1, -1, 0, 1};
     const int8_t shift = 2;
 
-    Special_Parameter result{false, {}, {}};
+    check.kingAttacked = false;
+    check.pinned = 0;
+    check.pinCount = 0;
     std::pair<int, int> kingPos = findKing(side, board);
+    int kingSquare = squareOf(kingPos.first, kingPos.second);
+    uint64_t occupancy = board->getOccupancy();
+    uint64_t friends = board->getColorMask(side);
 
     // Knight checks
-    for (int j = -2; j <= 2; j += 4) {
-        for (int i = -1; i <= 1; i += 2) {
-            int x = kingPos.second + j;
-            int y = kingPos.first + i;
-            if (x >= 0 && x < BOARDSIZE && y >= 0 && y < BOARDSIZE) {
-                if (board[y][x]->getCode() == KNIGHT && board[y][x]->isWhite() != side) {
-                    result.saveKingPath.push_back({y, x});
-                    result.kingAttacked = true;
-                }
-            }
-            x = kingPos.second + i;
-            y = kingPos.first + j;
-            if (x >= 0 && x < BOARDSIZE && y >= 0 && y < BOARDSIZE) {
-                if (board[y][x]->getCode() == KNIGHT && board[y][x]->isWhite() != side) {
-                    result.saveKingPath.push_back({y, x});
-                    result.kingAttacked = true;
-                }
-            }
-        }
+    uint64_t knights = knightAttacks(kingSquare) & board->getPieceMask(!side, KNIGHT);
+    uint64_t savePath = knights;
+    if (knights) {
+        check.kingAttacked = true;
     }
 
-    // Rook/Bishop/Queen checks
+    // Rook/Bishop/Queen checks. Walks to the nearest piece of every ray, and past it
+    // to the next one when the nearest is friendly (a possible pin).
     for (int c = 0; c < 8; ++c) {
-        Figure_Move_Restriction restriction = {{-1, -1}, {}};
-        int distance = 0;
-
-        int x = kingPos.second + rotation[c];
-        int y = kingPos.first + rotation[c + shift];
-
-        while (x < BOARDSIZE && y < BOARDSIZE && x >= 0 && y >= 0) {
-            ChessPieceBase* candidate = board[y][x];
-            restriction.unrestrictedPositions.push_back({y, x});
-
-            if (candidate->getCode() != EMPTY) {
-                if (candidate->isWhite() != side) {
-                    // Check if the piece threatens the king
-                    if (isDangerous(distance, kingPos, rotation[c], rotation[c + shift], candidate)) {
-                        // If no friendly piece was encountered before
-                        if (restriction.position == std::pair<int,int>{-1, -1}) {
-                            result.kingAttacked = true;
-                            // Merge path if king is already attacked by something else
-                            if (!result.saveKingPath.empty()) {
-                                result.saveKingPath = getOverlap(
-                                    result.saveKingPath,
-                                    restriction.unrestrictedPositions
-                                );
-                            } else {
-                                result.saveKingPath = restriction.unrestrictedPositions;
-                            }
-                            break;
-                        } else {
-                            result.restrictions.push_back(restriction);
-                            break;
-                        }
-                    } else {
-                        break;
-                    }
-                } else {
-                    // If we haven't encountered a friendly piece yet, store it
-                    if (restriction.position == std::pair<int,int>{-1, -1}) {
-                        restriction.position = {y, x};
-                    } else {
-                        // Already found a friendly piece, so stop
-                        break;
-                    }
-                }
+        uint64_t ray = rayMask(c, kingSquare);
+        uint64_t blockers = ray & occupancy;
+        if (!blockers) {
+            continue;
+        }
+        int first = isPositiveDirection(c) ? lowestSquare(blockers) : highestSquare(blockers);
+        int pinned = -1;
+        int target = first;
+
+        if (friends & squareBit(first)) {
+            blockers &= rayMask(c, first);
+            if (!blockers) {
+                continue;
             }
-            distance++;
-            x += rotation[c];
-            y += rotation[c + shift];
+            target = isPositiveDirection(c) ? lowestSquare(blockers) : highestSquare(blockers);
+            if (friends & squareBit(target)) {
+                // Already found a friendly piece, so stop
+                continue;
+            }
+            pinned = first;
+        }
+
+        // Squares between the king and the attacker, both ends excluded
+        int distance = countSquares(ray & ~rayMask(c, target)) - 1;
+        ChessPiece candidate = board->getPiece(target);
+        if (!isDangerous(distance, rotation[c], rotation[c + shift], candidate)) {
+            continue;
+        }
+
+        uint64_t path = ray & ~rayMask(c, target);
+        if (pinned == -1) {
+            check.kingAttacked = true;
+            // Merge path if king is already attacked by something else
+            savePath = savePath ? (savePath & path) : path;
+        } else {
+            check.pinned |= squareBit(pinned);
+            check.pinSquares[check.pinCount] = pinned;
+            check.pinPaths[check.pinCount] = path;
+            check.pinCount++;
         }
     }
 
-    return result;
+    check.saveKingPath = savePath;
 }
 
 /**
  * @brief ChessBoard destructor - cleans up the board.
  */
 ChessBoard::~ChessBoard() {
-    deleteBoard(this->board);
     if (log) {
         log->log("BOARD DELETED");
     }
@@ -1,11 +1,18 @@
 #pragma once
 
+#include "chess-arena.h"
+#include "chess-bitboard.h"
+#include "chess-board-state.h"
 #include "chess-peice.h"
+#include "chess-zobrist.h"
+#include <chrono>
+#include <cstdlib>
 #include <future>
 #include <map>
 #include <set>
 #include <sstream>
 #include <thread>
+#include <type_traits>
 
 class IOhandler;
 
@@ -20,6 +27,39 @@ struct Move {
   std::pair<int, int> end;
 };
 
+/**
+ * @brief Expands a packed move into a Move.
+ */
+inline Move unpackMove(PackedMove move) {
+  return {{moveFrom(move) / BOARDSIZE, moveFrom(move) % BOARDSIZE},
+          {moveTo(move) / BOARDSIZE, moveTo(move) % BOARDSIZE}};
+}
+
+/**
+ * @brief Packs a Move; the inverse of unpackMove.
+ */
+inline PackedMove packMove(const Move &move) {
+  return packMove(move.start.first * BOARDSIZE + move.start.second,
+                  move.end.first * BOARDSIZE + move.end.second);
+}
+
+/**
+ * @brief The moment by which a search has to return its move.
+ */
+typedef std::chrono::steady_clock::time_point Deadline;
+
+/**
+ * @brief Deadline of a search that may run until it is done.
+ */
+const Deadline NO_DEADLINE = Deadline::max();
+
+/**
+ * @brief True once `deadline` has passed; never for NO_DEADLINE.
+ */
+inline bool deadlinePassed(Deadline deadline) {
+  return deadline != NO_DEADLINE && std::chrono::steady_clock::now() >= deadline;
+}
+
 struct LastMove : Move
 {
   ChessPieceCode code;
@@ -36,6 +76,11 @@ struct Move_Candidate {
   float dScore;  ///< The score or change in score attributed to this move.
 };
 
+/**
+ * @brief Scratch memory for the candidate lists of one search thread.
+ */
+typedef Arena<Move_Candidate> CandidateArena;
+
 /**
  * @struct Figure_Move_Restriction
  * @brief Restricts the valid moves of a specific piece (e.g., when pinned or saving the king).
@@ -56,19 +101,32 @@ struct Special_Parameter {
   std::vector<std::pair<int, int>> saveKingPath; ///< The squares that would resolve a check situation.
   std::vector<Figure_Move_Restriction> restrictions; ///< Movement restrictions for certain pieces.
 };
+
+/**
+ * @struct Check_Masks
+ * @brief Bitboard form of Special_Parameter, used by the move generator.
+ */
+struct Check_Masks {
+  bool kingAttacked;     ///< Indicates if the king is currently under attack.
+  uint64_t saveKingPath; ///< The squares that would resolve a check situation.
+  uint64_t pinned;       ///< Pieces that may only move along their pin line.
+  int pinCount;          ///< Number of entries in pinSquares and pinPaths.
+  int pinSquares[8];     ///< Square of each pinned piece, in ray order.
+  uint64_t pinPaths[8];  ///< Squares each pinned piece may move to.
+};
 class ChessBoard;
 /**
  * @struct Thread_Parameter
- * @brief Used for multithreading operations in AI or move calculation.
+ * @brief One root candidate of the beam search, as a thread pool task evaluates it.
  */
 struct Thread_Parameter {
-  ChessBoard* board; ///< The chessboard on which operations are performed.
+  ChessBoard* board; ///< The root position; only read, shared by all tasks.
+  Move move;               ///< The candidate, played on a copy of the root.
   bool white;              ///< Indicates if this parameter applies to white (true) or black (false).
   int difficulty;          ///< The difficulty level for AI computations.
-  int depth;               ///< Current search depth.
   int maxDepth;            ///< Maximum search depth.
-  bool ready;              ///< Flag indicating if the thread is ready to start or has completed.
   float score;             ///< The resulting score from this thread's computations.
+  Deadline deadline;       ///< When the thread has to give up.
 };
 
 /**
@@ -83,32 +141,47 @@ struct Thread_Parameter {
 class ChessBoard {
 private:
   /**
-   * @brief Creates a row filled with pawns for the specified color.
-   * @param white True if creating a row of white pawns, false if black.
-   * @return A pointer to an array of ChessPieceBase pointers representing one row.
+   * @brief Writes one square of the state and keeps the bitboards in step.
+   * @param row Row of the square.
+   * @param col Column of the square.
+   * @param value The encoded occupant (see encodeSquare).
+   */
+  void setSquare(int row, int col, uint8_t value);
+
+  /**
+   * @brief Empties every square and forgets the last move.
    */
-  ChessPieceBase **createPawnRow(bool white);
+  void resetState();
 
   /**
-   * @brief Creates an empty row of 8 squares.
-   * @param row The row index to initialize (possibly for debugging or clarity).
-   * @return A pointer to an array of ChessPieceBase pointers representing one empty row.
+   * @brief Recomputes state.attackMaps of both colors and marks them valid.
    */
-  ChessPieceBase **createEmptyRow(int row);
+  void buildAttackMaps();
 
   /**
-   * @brief Creates the first (or last) row for a color (Rook, Knight, Bishop, Queen, King, etc.).
-   * @param white True if creating pieces for white side, false if black side.
-   * @return A pointer to an array of ChessPieceBase pointers for that back rank.
+   * @brief The body of generateLegalMoves, specialized on the color to move.
    */
-  ChessPieceBase **createFirstRow(bool white);
+  template <bool White> void appendLegalMoves(MoveList &out, const Check_Masks &masks);
+
+  /**
+   * @brief The en passant part of state.key: the column of a pawn that just made a
+   *        double step, 0 otherwise.
+   */
+  uint64_t enPassantKey() const
+  {
+    if (state.lastCode == PAWN && state.lastFirstMove &&
+        std::abs(state.lastEnd[0] - state.lastStart[0]) == 2) {
+      return ZOBRIST.enPassant[state.lastEnd[1]];
+    }
+    return 0;
+  }
 
 protected:
   Logger *log;               ///< Pointer to a Logger instance for logging.
-  ChessPieceBase ***board;   ///< 2D array (8x8) representing the board.
   int difficulty;            ///< Difficulty level for AI.
   int maxDepth;              ///< Maximum search depth for AI or game logic.
-  LastMove lastmove;
+  BoardState state;          ///< The position itself: squares, last move and bitboards.
+  UndoRecord *recording = nullptr; ///< Collects every square write while makeMove runs.
 
   /**
    * @brief Recursive evaluation function for AI or search algorithms.
@@ -118,15 +191,26 @@ protected:
    * @param depth Current depth in the recursive search.
    * @param maxDepth Maximum search depth to stop recursion.
    * @param worth Additional evaluation parameter for weighting.
+   * @param arena Holds the candidate list of every node on the current path.
+   * @param deadline Once it passes, every node returns 0 unsearched.
    * @return A float score representing the evaluation of the board.
    */
   static const float recursiveSubroutine(ChessBoard *board, bool white,
                                          int difficulty, int depth,
-                                         int maxDepth, float worth);
+                                         int maxDepth, float worth,
+                                         CandidateArena &arena,
+                                         Deadline deadline);
+
+  /**
+   * @brief recursiveSubroutine without the transposition table lookup.
+   */
+  static float expandBeamNode(ChessBoard *board, bool white, int difficulty, int depth,
+                              int maxDepth, float worth, CandidateArena &arena,
+                              Deadline deadline);
 
   /**
-   * @brief Thread function to perform parallel computations in certain AI scenarios.
-   * @param param Pointer to a Thread_Parameter containing relevant info for the thread.
+   * @brief Evaluates one root candidate of the beam search on a board of its own.
+   * @param param The candidate; its score is filled in.
    */
   static void threadFunc(Thread_Parameter *param);
 
@@ -181,55 +265,21 @@ public:
   /**
    * @brief Determines if a piece is dangerous for the king based on directional checks.
    * @param distance The distance from the suspect piece to the king.
-   * @param kingPos Position of the king.
    * @param dX Horizontal direction of interest.
    * @param dY Vertical direction of interest.
-   * @param suspect Pointer to the piece that might be threatening the king.
+   * @param suspect The piece that might be threatening the king.
    * @return True if the suspect piece is dangerous in that direction, false otherwise.
    */
-  static bool isDangerous(int distance, std::pair<int, int> kingPos, int8_t dX,
-                          int8_t dY, ChessPieceBase *suspect);
+  static bool isDangerous(int distance, int8_t dX, int8_t dY, const ChessPiece &suspect);
 
   /**
-   * @brief Factory method to create a new chess piece based on the given parameters.
-   * @param x The row coordinate.
-   * @param y The column coordinate.
-   * @param color True if white, false if black.
-   * @param code The piece code (KING, QUEEN, etc.).
-   * @param log Pointer to a Logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the piece has moved before.
-   * @return A pointer to the newly created ChessPieceBase.
-   */
-  static ChessPieceBase *createPeice(int x, int y, bool color,
-                                     ChessPieceCode code, Logger *log,
-                                     ChessBoard *board,
-                                     bool moved_ = false);
-
-  /**
-   * @brief Reverts the board from an imaginary state to a real state.
-   * @param imgainaryBoard Source board to revert from.
-   * @param board Destination board to restore to.
+   * @brief Copies the position of `board` into `imaginaryBoard`.
+   * @param imaginaryBoard Destination board, typically a search scratch board.
+   * @param board Source board.
    */
   static void revertBoard(ChessBoard* imaginaryBoard,
                           ChessBoard* board);
 
-  /**
-   * @brief Deletes a dynamically allocated chessboard array.
-   * @param board The board to delete.
-   * @return A null pointer (for convenience in assignment).
-   */
-  static ChessPieceBase ***deleteBoard(ChessPieceBase ***board);
-
-  /**
-   * @brief Creates a deep copy of the given board.
-   * @param board The source board to copy.
-   * @param notImaginary If true, indicates a full copy for the main game state, otherwise for simulations.
-   * @return A pointer to the new copy of the board.
-   */
-  static ChessPieceBase ***copyBoard(ChessBoard* chessBoardOld,
-     ChessBoard* chessBoardNew, bool notImaginary = false);
-
   /**
    * @brief Performs a move on the given board, potentially involving captures or special moves.
    * @param move The move to perform.
@@ -241,24 +291,78 @@ public:
   float performMove(const Move &move, IOhandler* handler,
                                   bool overrideRightess = false);
 
+  /**
+   * @brief Performs a move the way the search does (forced, promoting to a queen)
+   *        and records what it changed.
+   * @param move The move to perform.
+   * @param undo Filled with everything unmakeMove needs to take the move back.
+   * @return The score performMove returned for the move.
+   * @throws Whatever performMove throws; the board is left unchanged in that case.
+   */
+  float makeMove(const Move &move, UndoRecord &undo);
+
+  /**
+   * @brief Takes back a move made by makeMove. Moves must be unmade in reverse order.
+   * @param undo The record filled by makeMove.
+   */
+  void unmakeMove(const UndoRecord &undo);
+
+  /**
+   * @brief The score makeMove would return for `move`, bit for bit, read off the
+   *        current position: captures and the non-king moves that do not promote
+   *        are scored without touching the board. King moves, castling and
+   *        promotions, whose threats depend on more of the new position, are made
+   *        and unmade.
+   * @throws What makeMove throws for the move.
+   */
+  float scoreMove(const Move &move);
+
+  /**
+   * @brief Value of the position for `white` at a search's horizon: the best
+   *        immediate score of a move that is not a capture (stand pat), or a
+   *        capture followed by the opponent's own quiescence, whichever is
+   *        higher. Captures are tried most valuable victim first, then least
+   *        valuable attacker. With `plies` at 0 captures count with their
+   *        immediate score only, which is the plain best immediate score.
+   *        Fail-soft: a result <= alpha or >= beta is a bound only.
+   * @param white The side to move.
+   * @param alpha The score the caller already has.
+   * @param beta The score past which the caller does not need the exact value.
+   * @param plies Captures still to follow.
+   * @param bestMove If given, receives the move behind the result, 0 if none.
+   * @return The value, Mate or Pate if the side has no move.
+   */
+  float quiescence(bool white, float alpha, float beta, int plies,
+                   PackedMove *bestMove = nullptr);
+
   /**
    * @brief Prints a representation of an imaginary board to the specified output stream.
    * @param board The board to print.
    * @param out The output stream to print to (default is std::cout).
    */
-  static void printImaginaryBoard(ChessPieceBase ***board,
+  static void printImaginaryBoard(ChessBoard *board,
                                   std::ostream *out = &std::cout);
 
   /**
-   * @brief Filters a set of candidate moves based on check or pin restrictions.
-   * @param input The original list of candidate positions.
+   * @brief Filters a list of candidate moves in place based on check or pin restrictions.
+   * @param moves The candidate moves of one piece; only the valid ones are kept.
    * @param checkMate Special_Parameter with info about king attacks and pins.
    * @param usedIndex The index of the piece in checkMate.restrictions.
-   * @return A list of valid candidate positions after applying restrictions.
    */
-  static std::vector<std::pair<int, int>>
-  filterMoves(const std::vector<std::pair<int, int>> &input,
-              Special_Parameter checkMate, int usedIndex);
+  static void filterMoves(MoveList &moves, const Special_Parameter &checkMate, int usedIndex);
+
+  /**
+   * @brief Appends every legal move of one color: captures then quiet moves of each
+   *        piece, pieces in row-major order. The one generator used by the search
+   *        and by the IO handler.
+   *
+   * In check, pieces only generate moves onto the save path (captures of the
+   * checker and interpositions); in double check only the king moves.
+   * @param white The color to move.
+   * @param out Receives the moves.
+   * @param check If not null, receives the check and pin info the moves were restricted by.
+   */
+  void generateLegalMoves(bool white, MoveList &out, Check_Masks *check = nullptr);
 
   /**
    * @brief Evaluates if the side's king is in checkmate or if there are pinned pieces, etc.
@@ -266,7 +370,15 @@ public:
    * @param board The current board.
    * @return A Special_Parameter struct describing the check/pin state.
    */
-  static Special_Parameter evaluateCheckMate(bool side, ChessPieceBase ***board);
+  static Special_Parameter evaluateCheckMate(bool side, ChessBoard *board);
+
+  /**
+   * @brief Same evaluation as evaluateCheckMate, returned as bitboards.
+   * @param side True if evaluating for white, false if black.
+   * @param board The current board.
+   * @param check Receives the check/pin state.
+   */
+  static void evaluateCheckMasks(bool side, ChessBoard *board, Check_Masks &check);
 
   /**
    * @brief Simplified checkmate evaluation to see if a side's king is under check and has no moves.
@@ -277,7 +389,7 @@ public:
    */
   static bool simplifiedEvaluateCheckMate(bool side,
                                           std::pair<int, int> kingPosition,
-                                          ChessPieceBase ***board);
+                                          ChessBoard *board);
 
   /**
    * @brief Finds the position of the king for the specified side.
@@ -285,33 +397,15 @@ public:
    * @param board The board to search.
    * @return A pair (row, col) representing the king's position, or (-1, -1) if not found.
    */
-  static std::pair<int, int> findKing(bool side, ChessPieceBase ***board);
+  static std::pair<int, int> findKing(bool side, ChessBoard *board);
 
   /**
-   * @brief Creates a chess piece from a string-based code (used in loading or string-based setups).
-   * @param x Row coordinate.
-   * @param y Column coordinate.
-   * @param color True if white, false if black.
-   * @param code The character code representing the piece.
-   * @param log Pointer to a Logger instance for logging.
-   * @param board Pointer to the board.
-   * @param moved_ Indicates if the piece has already moved.
-   * @return A pointer to the created ChessPieceBase.
+   * @brief Keeps, in place, only the moves that end on one of the given positions.
+   * @param moves The moves to filter.
+   * @param positions The allowed destinations.
    */
-  static ChessPieceBase *createPeiceFromString(int x, int y, bool color,
-                                               char code, Logger *log,
-                                               ChessBoard *board,
-                                               bool moved_ = false);
-
-  /**
-   * @brief Returns the intersection (overlap) of two position sets.
-   * @param el1 First vector of positions.
-   * @param el2 Second vector of positions.
-   * @return A vector of positions that appear in both el1 and el2.
-   */
-  static std::vector<std::pair<int, int>>
-  getOverlap(const std::vector<std::pair<int, int>> &el1,
-             const std::vector<std::pair<int, int>> &el2);
+  static void getOverlap(MoveList &moves,
+                         const std::vector<std::pair<int, int>> &positions);
 
   /**
    * @brief Getter for the difficulty level.
@@ -319,6 +413,11 @@ public:
    */
   int getDifficulty() { return difficulty; }
 
+  /**
+   * @brief Plies the search looks below the root moves at the current difficulty.
+   */
+  int getSearchDepth() { return (difficulty < 6) ? difficulty : (difficulty / 2); }
+
   /**
    * @brief Rebuilds the board from a string representation (for predefined games or test states).
    * @param str The string containing board data.
@@ -334,17 +433,62 @@ public:
   void printBoard(bool white, std::ostream *out = &std::cout, bool server = false);
 
   /**
-   * @brief Determines the best move for a given side using the current difficulty.
+   * @brief Determines the best move for a given side using the current difficulty
+   *        and the selected searchEngine.
    * @param white True if calculating the best move for white, false for black.
+   * @param deadline When the move is due. Before it the search deepens one ply
+   *        at a time up to the difficulty's depth; once it passes, the move of
+   *        the deepest finished iteration is returned.
    * @return A Move struct describing the best move found.
    */
-  Move getBestMove(bool white);
+  Move getBestMove(bool white, Deadline deadline = NO_DEADLINE);
+
+  /**
+   * @brief getBestMove with the BEAM engine (the "drunk" personality), which
+   *        also reports the score the move was chosen by.
+   * @param white The side to move.
+   * @param maxDepth Plies searched below the root candidates.
+   * @param deadline When the move is due.
+   * @return The move with its dScore less the `worth`-weighted best reply, or
+   *         with its plain dScore if maxDepth is 0; {{-1, -1}, {-1, -1}} and 0
+   *         if the side has no move.
+   */
+  Move_Candidate getBeamMove(bool white, int maxDepth, Deadline deadline);
+
+  /**
+   * @brief getBestMove with the ALPHA_BETA engine.
+   * @param white The side to move.
+   * @param maxDepth The beam's depth at this difficulty, which sets the node
+   *        budget; the search goes at least one ply deeper.
+   * @param deadline When the move is due.
+   */
+  Move getAlphaBetaMove(bool white, int maxDepth, Deadline deadline);
+
+  /**
+   * @brief One beam search of the root candidates, `maxDepth` plies below them.
+   * @param white The side to move.
+   * @param topCandidates The root moves kept by the beam, best dScore first.
+   * @param maxDepth Plies searched below each candidate.
+   * @param deadline When the search has to give up.
+   * @param bestIndex Receives the index of the best candidate if the search finished.
+   * @param bestScore Receives that candidate's score.
+   * @return False if the deadline cut the search short.
+   */
+  bool runBeamIteration(bool white, const std::vector<Move_Candidate> &topCandidates,
+                        int maxDepth, Deadline deadline, int &bestIndex,
+                        float &bestScore);
+
+  /**
+   * @brief The piece on a square (an EMPTY piece if the square is free).
+   * @param row Row of the square.
+   * @param col Column of the square.
+   */
+  ChessPiece getPiece(int row, int col) { return ChessPiece(this, squareOf(row, col)); }
 
   /**
-   * @brief Getter for the internal board representation.
-   * @return A pointer to the 2D array (8x8) of ChessPieceBase pointers.
+   * @brief The piece on a square given by index (row * 8 + col).
    */
-  ChessPieceBase ***getBoard() { return board; }
+  ChessPiece getPiece(int square) { return ChessPiece(this, square); }
 
   /**
    * @brief Debug function to print advanced data about the board, possibly threats or pinned pieces.
@@ -368,7 +512,7 @@ public:
    * @return A set of board positions that are under threat.
    */
   static std::set<std::pair<int, int>>
-  getDangerousPoints(ChessPieceBase ***board, bool white);
+  getDangerousPoints(ChessBoard *board, bool white);
 
   /**
    * @brief Clears the board or resets it to an empty state (implementation depends on usage).
@@ -392,12 +536,113 @@ public:
 
   LastMove getLastMove()
   {
-    return lastmove;
+    return {{{state.lastStart[0], state.lastStart[1]}, {state.lastEnd[0], state.lastEnd[1]}},
+            ChessPieceCode(state.lastCode), state.lastFirstMove};
   }
   
   void setLastMove(LastMove move)
   {
-    lastmove = move;
+    state.key ^= enPassantKey();
+    state.lastStart[0] = move.start.first;
+    state.lastStart[1] = move.start.second;
+    state.lastEnd[0] = move.end.first;
+    state.lastEnd[1] = move.end.second;
+    state.lastCode = move.code;
+    state.lastFirstMove = move.firstMove;
+    state.key ^= enPassantKey();
+  }
+
+  /**
+   * @brief Zobrist key of the position with the given side to move.
+   *
+   * Kept up to date by every square write and every change of the last move, so
+   * reading it costs nothing. Two positions with equal squares, moved flags and
+   * en passant state share a key.
+   * @param whiteToMove True if White is the side to move.
+   */
+  uint64_t getKey(bool whiteToMove)
+  {
+    return state.key ^ (whiteToMove ? ZOBRIST.whiteToMove : 0);
+  }
+
+  /**
+   * @brief The whole position as a plain value.
+   */
+  const BoardState &getState()
+  {
+    return state;
+  }
+
+  /**
+   * @brief Replaces the position with `snapshot`.
+   * @param snapshot The position to restore.
+   */
+  void loadState(const BoardState &snapshot);
+
+  /**
+   * @brief Squares occupied by pieces of one color and type.
+   * @param white True for white pieces, false for black.
+   * @param code The piece type (KING..PAWN).
+   */
+  uint64_t getPieceMask(bool white, ChessPieceCode code)
+  {
+    return state.pieceMasks[white][code];
+  }
+
+  /**
+   * @brief Squares occupied by pieces of one color.
+   * @param white True for white pieces, false for black.
+   */
+  uint64_t getColorMask(bool white)
+  {
+    return state.colorMasks[white];
+  }
+
+  /**
+   * @brief Squares occupied by any piece.
+   */
+  uint64_t getOccupancy()
+  {
+    return state.colorMasks[0] | state.colorMasks[1];
+  }
+
+  /**
+   * @brief Calls `visit(square, piece)` for every piece of one color, in row-major
+   *        order. Only occupied squares are visited: the color masks act as the
+   *        side's piece list and are kept up to date by every square write.
+   * @param white The color whose pieces are visited.
+   */
+  template <typename Visitor> void forEachPiece(bool white, Visitor visit)
+  {
+    forEachSquare(state.colorMasks[white], [&](int square) {
+      visit(square, ChessPiece(this, square));
+    });
+  }
+
+  /**
+   * @brief Squares attacked by the pieces of one color, by the rules of
+   *        simplifiedEvaluateCheckMate. Built on first use after a change and
+   *        restored by unmakeMove, so repeated queries cost one lookup.
+   *
+   * The maps are not updated move by move. That would need attacker counts per
+   * square and every slider's rays redone at each square write, which costs
+   * more than one rebuild of a dozen table lookups per position searched.
+   * @param white The attacking color.
+   */
+  uint64_t getAttackMap(bool white)
+  {
+    if (!state.attackMapsValid) {
+      buildAttackMaps();
+    }
+    return state.attackMaps[white];
+  }
+
+  /**
+   * @brief True if `square` is attacked by the given color (see getAttackMap).
+   */
+  bool isSquareAttacked(bool byWhite, int square)
+  {
+    return getAttackMap(byWhite) & squareBit(square);
   }
 
   /**
@@ -413,3 +658,15 @@ public:
    */
   ~ChessBoard();
 };
+
+inline ChessPieceCode ChessPiece::getCode() const {
+  return squareCode(chessBoard->getState().squares[square]);
+}
+
+inline bool ChessPiece::isWhite() const {
+  return squareWhite(chessBoard->getState().squares[square]);
+}
+
+inline bool ChessPiece::hasMoved() const {
+  return squareMoved(chessBoard->getState().squares[square]);
+}
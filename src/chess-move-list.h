@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * @file   chess-move-list.h
+ * @brief  Fixed-capacity, allocation-free list of moves.
+ */
+
+/**
+ * @brief The maximum allowed recursion depth (for example, in AI search).
+ *        Also the capacity of a MoveList.
+ */
+#define MAXDEPTH 256
+
+/**
+ * @brief A move packed into 16 bits: start square in bits 0-5, end square in bits 6-11.
+ *        Squares are indexed row * 8 + col.
+ */
+typedef uint16_t PackedMove;
+
+inline PackedMove packMove(int from, int to) {
+  return PackedMove(from | (to << 6));
+}
+
+inline int moveFrom(PackedMove move) { return move & 63; }
+
+inline int moveTo(PackedMove move) { return (move >> 6) & 63; }
+
+/**
+ * @class MoveList
+ * @brief Up to MAXDEPTH packed moves stored inline, meant to live on the stack.
+ *
+ * Generators append to a list instead of returning vectors, so producing the
+ * moves of a node does not touch the heap.
+ */
+class MoveList {
+public:
+  static constexpr int CAPACITY = MAXDEPTH;
+
+  /**
+   * @brief Appends a move.
+   * @throws std::runtime_error if the list is full.
+   */
+  void push(int from, int to) {
+    if (count == CAPACITY) {
+      throw std::runtime_error("MOVE LIST OVERFLOW");
+    }
+    moves[count++] = packMove(from, to);
+  }
+
+  int size() const { return count; }
+
+  bool empty() const { return count == 0; }
+
+  void clear() { count = 0; }
+
+  PackedMove operator[](int index) const { return moves[index]; }
+
+  const PackedMove *begin() const { return moves; }
+
+  const PackedMove *end() const { return moves + count; }
+
+  /**
+   * @brief True if some move of the list ends on `to`.
+   */
+  bool containsTarget(int to) const {
+    for (int i = 0; i < count; ++i) {
+      if (moveTo(moves[i]) == to) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief Removes, in place and keeping the order, every move for which `keep` is false.
+   */
+  template <typename Predicate> void filter(Predicate keep) {
+    int kept = 0;
+    for (int i = 0; i < count; ++i) {
+      if (keep(moves[i])) {
+        moves[kept++] = moves[i];
+      }
+    }
+    count = kept;
+  }
+
+  /**
+   * @brief Sorts the list in place so that no move comes after one `less` puts
+   *        behind it; equal moves keep their order. Insertion sort, so nothing is
+   *        allocated.
+   */
+  template <typename Less> void sort(Less less) {
+    for (int i = 1; i < count; ++i) {
+      PackedMove move = moves[i];
+      int k = i;
+      while (k > 0 && less(move, moves[k - 1])) {
+        moves[k] = moves[k - 1];
+        --k;
+      }
+      moves[k] = move;
+    }
+  }
+
+private:
+  PackedMove moves[CAPACITY];
+  int count = 0;
+};
@@ -7,6 +7,8 @@ int Castling = 50;
 int prices[8] = {1100, 900, 500, 330, 320, 100, 0, -1};
 float ATTACK_COST = 0.05;
 float worth = 0.9;
+SearchEngine searchEngine = BEAM;
+int quiescencePlies[2] = {0, 4};
 
 int getScore(ChessPieceCode code) {
   switch (code) {
@@ -20,4 +20,22 @@ extern int Castling;
 extern float ATTACK_COST;
 extern float worth;
 
+/**
+ * @brief The search behind ChessBoard::getBestMove.
+ */
+enum SearchEngine {
+  BEAM,       ///< Best `difficulty` moves per ply, no pruning: the "drunk" personality.
+  ALPHA_BETA, ///< Every move, alpha-beta pruned, on the beam's node budget and a ply deeper.
+};
+
+extern SearchEngine searchEngine;
+
+/**
+ * @brief Plies of captures each search follows past its last ply before scoring
+ *        a position, by SearchEngine; see ChessBoard::quiescence. 0 scores the
+ *        last ply by its best immediate move alone, which the beam keeps unless
+ *        asked otherwise, so the drunk engine plays its original moves.
+ */
+extern int quiescencePlies[2];
+
 int getScore(ChessPieceCode code);
@@ -15,57 +15,100 @@
 
 
 /**
- * @brief  Helper function to detect if there is an opposing King on an adjacent square.
+ * @brief  Squares on or next to an opposing King, where a King of color `White` may not step.
  * @param  board  The chess board.
- * @param  pos    The position to check around.
- * @param  white  The color of the piece checking for an opposing King.
- * @return True if there is an enemy King in any adjacent square, false otherwise.
- */
-static bool isOpposingKingNearby(
-    ChessPieceBase*** board, 
-    std::pair<int,int> pos, 
-    bool white
-) {
-    int rowMin = std::max(0, pos.first - 1);
-    int rowMax = std::min(BOARDSIZE - 1, pos.first + 1);
-    int colMin = std::max(0, pos.second - 1);
-    int colMax = std::min(BOARDSIZE - 1, pos.second + 1);
-
-    for (int row = rowMin; row <= rowMax; ++row) {
-        for (int col = colMin; col <= colMax; ++col) {
-            if (board[row][col]->getCode() == KING &&
-                board[row][col]->isWhite() != white)
-            {
-                return true;
-            }
-        }
+ * @return A mask of the forbidden squares.
+ */
+template <bool White>
+static uint64_t opposingKingZone(ChessBoard* board) {
+    uint64_t zone = 0;
+    forEachSquare(board->getPieceMask(!White, KING), [&](int square) {
+        zone |= kingAttacks(square) | squareBit(square);
+    });
+    return zone;
+}
+
+/**
+ * @brief  Squares a piece of color `White` may take: enemy pieces, plus the empty
+ *         squares when `All` is set.
+ */
+template <bool White, bool All>
+static uint64_t attackTargets(ChessBoard* board) {
+    if constexpr (All) {
+        return board->getColorMask(!White) | ~board->getOccupancy();
+    } else {
+        return board->getColorMask(!White);
     }
-    return false;
 }
 
-//======================== ChessPieceBase Methods ========================//
+/**
+ * @brief  One square forward for a pawn of color `White`; squares off the board drop out.
+ */
+template <bool White>
+static uint64_t pawnPush(uint64_t mask) {
+    if constexpr (White) {
+        return mask << BOARDSIZE;
+    } else {
+        return mask >> BOARDSIZE;
+    }
+}
 
-ChessPieceCode ChessPieceBase::getCode() {
-    return code;
+/**
+ * @brief  Appends the squares of `mask` in ascending square order.
+ */
+static void appendSquares(MoveList &out, int from, uint64_t mask) {
+    forEachSquare(mask, [&](int square) {
+        out.push(from, square);
+    });
 }
-ChessPieceBase::ChessPieceBase(int x, int y, bool color, Logger *log,
-    ChessBoard* chessBoard, bool moved_ = false)
-    {
-        this->log = log;
-        this->x = x;
-        this->y = y;
-        this->chessBoard = chessBoard;
-        this->white = color;
-        this->moved = moved_;
+
+/**
+ * @brief  Appends the squares of `mask` the way a slider walks them: one direction
+ *         after another, each direction outwards from `square`.
+ */
+static void appendRays(MoveList &out, int square, uint64_t mask,
+                       const int *directions, int count) {
+    for (int i = 0; i < count; ++i) {
+        forEachOnRay(directions[i], mask & rayMask(directions[i], square), [&](int target) {
+            out.push(square, target);
+        });
     }
-bool ChessPieceBase::isPlayable() {
-    return playable;
 }
 
-bool ChessPieceBase::isWhite() {
-    return white;
+/**
+ * @brief  Knight jumps as (column, row) offsets, in the order candidates are reported.
+ */
+static const int knightOffsets[8][2] = {
+    { 2, 1}, { 2, -1}, {-2, 1}, {-2, -1},
+    { 1, 2}, { 1, -2}, {-1, 2}, {-1, -2},
+};
+
+/**
+ * @brief  Appends the squares of `mask` in the knight offset order.
+ */
+static void appendKnightSquares(MoveList &out, int square, uint64_t mask) {
+    int x = square % BOARDSIZE;
+    int y = square / BOARDSIZE;
+    for (auto &offset : knightOffsets) {
+        int newCol = x + offset[0];
+        int newRow = y + offset[1];
+        if (newCol >= 0 && newCol < BOARDSIZE &&
+            newRow >= 0 && newRow < BOARDSIZE &&
+            (mask & squareBit(squareOf(newRow, newCol))))
+        {
+            out.push(square, squareOf(newRow, newCol));
+        }
+    }
 }
 
+/**
+ * @brief  Ray order of the rook (down, left, up, right) and the bishop.
+ */
+static const int rookDirections[4] = {SOUTH, WEST, NORTH, EAST};
+static const int bishopDirections[4] = {NORTH_EAST, NORTH_WEST, SOUTH_EAST, SOUTH_WEST};
+
+//======================== ChessPieceBase Methods ========================//
+
 /**
  * @brief  Converts the internal piece code enum to a character.
  * @param  code  The ChessPieceCode enum value.
@@ -102,609 +145,248 @@ ChessPieceCode ChessPieceBase::getPieceCode(char chr) {
     }
 }
 
+//======================== ChessPiece Methods ========================//
+
 /**
  * @brief  Prints the piece in the format "[W/B][Symbol]", e.g. "WP" for a white pawn.
  */
-std::string ChessPieceBase::print() {
+std::string ChessPiece::print() const {
     std::string output;
-    output += (white ? 'W' : 'B');
-    output += ChessPieceBase::getSymb(this->code);
+    output += (isWhite() ? 'W' : 'B');
+    output += ChessPieceBase::getSymb(getCode());
     return output;
 }
 
 /**
  * @brief  Checks if the piece can move to the given position, by looking into move candidates.
  */
-bool ChessPieceBase::canMoveTo(const std::pair<int, int> &pnt) {
-    auto candidates = this->getMoveCandidates();
-    return (std::find(candidates.begin(), candidates.end(), pnt) != candidates.end());
+bool ChessPiece::canMoveTo(const std::pair<int, int> &pnt) const {
+    if (pnt.first < 0 || pnt.first >= BOARDSIZE || pnt.second < 0 || pnt.second >= BOARDSIZE) {
+        return false;
+    }
+    MoveList candidates;
+    getMoveCandidates(candidates, squareBit(squareOf(pnt.first, pnt.second)));
+    return !candidates.empty();
 }
 
 /**
  * @brief  Checks if the piece can attack the given position, by looking into attack candidates.
  */
-bool ChessPieceBase::canAttack(const std::pair<int, int> &pnt) {
-    auto candidates = this->getAttackCandidates(false);
-    return (std::find(candidates.begin(), candidates.end(), pnt) != candidates.end());
-}
-
-/**
- * @brief  Updates the piece's position and marks it as moved.
- * @param  dest  The destination in (row, col) format.
- */
-void ChessPieceBase::move(const std::pair<int, int> &dest) {
-    this->y = dest.first;
-    this->x = dest.second;
-    this->moved = true;
-}
-
-//======================== ChessPieceEmpty Methods ========================//
-
-ChessPieceEmpty::ChessPieceEmpty(
-    int x, int y, 
-    Logger *log,
-    ChessBoard *board
-) : ChessPieceBase(x,y,false,log,board) {
-    this->code = EMPTY;
-    this->playable = false;   // Not playable
-
-    if (log) {
-        log->log("EMPTY PIECE CREATED");
-    }
-}
-
-std::vector<std::pair<int, int>> ChessPieceEmpty::getMoveCandidates() {
-    return {};
-}
-
-std::vector<std::pair<int, int>> ChessPieceEmpty::getAttackCandidates(bool /*all*/) {
-    return {};
-}
-
-bool ChessPieceEmpty::canMoveTo(const std::pair<int, int> & /*pnt*/) {
-    return false;
-}
-
-bool ChessPieceEmpty::canAttack(const std::pair<int, int> & /*pnt*/) {
-    return false;
-}
-
-ChessPieceEmpty::~ChessPieceEmpty() {
-    if (log) {
-        log->log("EMPTY PIECE DELETED");
+bool ChessPiece::canAttack(const std::pair<int, int> &pnt) const {
+    if (pnt.first < 0 || pnt.first >= BOARDSIZE || pnt.second < 0 || pnt.second >= BOARDSIZE) {
+        return false;
     }
+    MoveList candidates;
+    getAttackCandidates(false, candidates, squareBit(squareOf(pnt.first, pnt.second)));
+    return !candidates.empty();
 }
 
 //======================== ChessPiecePawn Methods ========================//
 
-ChessPiecePawn::ChessPiecePawn(
-    int x, int y, 
-    bool color, 
-    Logger *log,
-    ChessBoard *board,
-    bool moved_
-) : ChessPieceBase(x, y, color, log, board, moved_) {
-
-    this->code = PAWN;
-    this->playable = true;
-    if (log) {
-        log->log("PAWN CREATED");
-    }
-}
 
 /**
  * @brief  Retrieves all possible non-attacking moves for a pawn.
  *         Pawns can typically move forward 1 step or 2 steps if they haven't moved yet.
  */
-std::vector<std::pair<int, int>> ChessPiecePawn::getMoveCandidates() {
-    std::vector<std::pair<int, int>> moves;
-    // If white = true, delta = +1; if white = false, delta = -1
-    int deltaRow = (white ? 1 : -1);
+template <bool White>
+void ChessPiecePawn<White>::getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out, uint64_t targets) {
+    constexpr int step = White ? BOARDSIZE : -BOARDSIZE;
+    uint64_t empty = ~board->getOccupancy();
 
     // The pawn can move one square forward if it's empty
-    int oneStepRow = y + deltaRow;
-    if (oneStepRow >= 0 && oneStepRow < BOARDSIZE) {
-        if (chessBoard->getBoard()[oneStepRow][x]->getCode() == EMPTY) {
-            moves.push_back({oneStepRow, x});
-        }
+    uint64_t oneStep = pawnPush<White>(squareBit(square)) & empty;
+    if (oneStep & targets) {
+        out.push(square, square + step);
     }
 
-    // If it hasn't moved, try a two-square move
-    if (!moved) {
-        int twoStepRow = y + 2 * deltaRow;
-        if (twoStepRow >= 0 && twoStepRow < BOARDSIZE) {
-            // Only if the intermediate and final squares are empty
-            if (chessBoard->getBoard()[oneStepRow][x]->getCode() == EMPTY &&
-                chessBoard->getBoard()[twoStepRow][x]->getCode() == EMPTY)
-            {
-                moves.push_back({twoStepRow, x});
-            }
-        }
+    // If it hasn't moved, try a two-square move; only if both squares are empty
+    if (!moved && (pawnPush<White>(oneStep) & empty & targets)) {
+        out.push(square, square + 2 * step);
     }
-
-    return moves;
 }
 
 /**
  * @brief  Retrieves all potential attacking squares for a pawn.
- *         Pawns attack diagonally forward (1 step). If all = true, 
- *         empty squares in front diagonally are also returned (for path checking).
- */
-std::vector<std::pair<int, int>> ChessPiecePawn::getAttackCandidates(bool all) {
-    std::vector<std::pair<int, int>> attacks;
-    int deltaRow = (white ? 1 : -1);
-    int newRow = y + deltaRow;
-
-    // Pawn can attack diagonally left or right
-    for (int deltaCol = -1; deltaCol <= 1; deltaCol += 2) {
-        int newCol = x + deltaCol;
-        if (newRow >= 0 && newRow < BOARDSIZE &&
-            newCol >= 0 && newCol < BOARDSIZE)
-        {
-            ChessPieceCode targetCode = chessBoard->getBoard()[newRow][newCol]->getCode();
-            bool targetColor = chessBoard->getBoard()[newRow][newCol]->isWhite();
-            //En passant
-            if(targetCode == EMPTY)
-            {
-                if( chessBoard->getLastMove().code == PAWN &&
-                    chessBoard->getLastMove().firstMove &&
-                    chessBoard->getLastMove().end.second == newCol &&
-                    abs(chessBoard->getLastMove().end.first - chessBoard->getLastMove().start.first) == 2)
-                    {
-                        attacks.push_back({newRow, newCol});
-                    }
-            }
-
-            // If the target is empty and 'all' is set, we include it for possible path usage
-            else if (targetCode == EMPTY && all) {
-                attacks.push_back({newRow, newCol});
-            }
+ *         Pawns attack diagonally forward (1 step); an empty diagonal only counts
+ *         for en passant. The two squares come out left to right.
+ */
+template <bool White>
+template <bool All>
+void ChessPiecePawn<White>::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    appendSquares(out, square, getAttackMask<All>(board, square) & targets);
+}
 
-            // If there is an enemy piece, we can attack it
-            else if (targetCode != EMPTY && targetColor != white) {
-                attacks.push_back({newRow, newCol});
+/**
+ * @brief  Diagonal squares holding an enemy piece, plus the en passant square.
+ *         `All` does not add the empty diagonals: the en passant branch takes them first.
+ */
+template <bool White>
+template <bool All>
+uint64_t ChessPiecePawn<White>::getAttackMask(ChessBoard *board, int square) {
+    uint64_t reach = pawnAttacks(White, square);
+    uint64_t attacks = reach & board->getColorMask(!White);
+
+    //En passant
+    LastMove last = board->getLastMove();
+    if (last.code == PAWN &&
+        last.firstMove &&
+        abs(last.end.first - last.start.first) == 2)
+    {
+        forEachSquare(reach & ~board->getOccupancy(), [&](int target) {
+            if (target % BOARDSIZE == last.end.second) {
+                attacks |= squareBit(target);
             }
-        }
+        });
     }
 
     return attacks;
 }
 
-ChessPiecePawn::~ChessPiecePawn() {
-    if (log) {
-        log->log("PAWN DELETED");
-    }
-}
 
 //======================== ChessPieceKnight Methods ========================//
 
-ChessPieceKnight::ChessPieceKnight(
-    int x, int y, bool color, 
-    Logger *log, 
-    ChessBoard *board,
-    bool moved_
-) : ChessPieceBase(x, y, color, log, board, moved_) {
-    this->code = KNIGHT;
-    this->playable = true;
-
-
-    if (log) {
-        log->log("KNIGHT CREATED");
-    }
-}
 
 /**
  * @brief  Knight move candidates (L-shaped moves). This excludes attacks on non-empty squares,
  *         so it only includes moves to EMPTY squares for normal movement.
  */
-std::vector<std::pair<int, int>> ChessPieceKnight::getMoveCandidates() {
-    std::vector<std::pair<int, int>> moves;
-    // Knight moves in +/-2 row, +/-1 col or +/-1 row, +/-2 col
-    static const int offsets[8][2] = {
-        { 2, 1}, { 2, -1}, {-2, 1}, {-2, -1},
-        { 1, 2}, { 1, -2}, {-1, 2}, {-1, -2},
-    };
-
-    for (auto &offset : offsets) {
-        int newCol = x + offset[0];
-        int newRow = y + offset[1];
-        if (newCol >= 0 && newCol < BOARDSIZE &&
-            newRow >= 0 && newRow < BOARDSIZE)
-        {
-            if (chessBoard->getBoard()[newRow][newCol]->getCode() == EMPTY) {
-                moves.push_back({newRow, newCol});
-            }
-        }
+template <bool White>
+void ChessPieceKnight<White>::getMoveCandidates(ChessBoard *board, int square, bool /*moved*/, MoveList &out, uint64_t targets) {
+    targets &= knightAttacks(square) & ~board->getOccupancy();
+    if (targets) {
+        appendKnightSquares(out, square, targets);
     }
-
-    return moves;
 }
 
 /**
  * @brief  Knight attack candidates can attack an enemy piece on any L-shaped position, 
- *         or (if all == true) includes empty squares for path-based computations.
+ *         or (if All) includes empty squares for path-based computations.
  */
-std::vector<std::pair<int, int>> ChessPieceKnight::getAttackCandidates(bool all) {
-    std::vector<std::pair<int, int>> attacks;
-    static const int offsets[8][2] = {
-        { 2, 1}, { 2, -1}, {-2, 1}, {-2, -1},
-        { 1, 2}, { 1, -2}, {-1, 2}, {-1, -2},
-    };
-
-    for (auto &offset : offsets) {
-        int newCol = x + offset[0];
-        int newRow = y + offset[1];
-        if (newCol >= 0 && newCol < BOARDSIZE &&
-            newRow >= 0 && newRow < BOARDSIZE)
-        {
-            ChessPieceCode targetCode = chessBoard->getBoard()[newRow][newCol]->getCode();
-            bool targetColor = chessBoard->getBoard()[newRow][newCol]->isWhite();
-
-            // Attack enemy piece or include empty squares if 'all' is requested
-            if ((targetCode != EMPTY && targetColor != white) ||
-                (all && targetCode == EMPTY))
-            {
-                attacks.push_back({newRow, newCol});
-            }
-        }
+template <bool White>
+template <bool All>
+void ChessPieceKnight<White>::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    targets &= getAttackMask<All>(board, square);
+    if (targets) {
+        appendKnightSquares(out, square, targets);
     }
-
-    return attacks;
 }
 
-ChessPieceKnight::~ChessPieceKnight() {
-    if (log) {
-        log->log("KNIGHT DELETED");
-    }
+template <bool White>
+template <bool All>
+uint64_t ChessPieceKnight<White>::getAttackMask(ChessBoard *board, int square) {
+    return knightAttacks(square) & attackTargets<White, All>(board);
 }
 
+
 //======================== ChessPieceRook Methods ========================//
 
-ChessPieceRook::ChessPieceRook(
-    int x, int y, bool color, 
-    Logger *log, 
-    ChessBoard *board,
-    bool moved_
-) : ChessPieceBase(x, y, color, log, board, moved_) {
-    this->code = ROOK;
-    this->playable = true;
-
-    if (log) {
-        log->log("ROOK CREATED");
-    }
-}
 
 /**
  * @brief  Rook move candidates: move along rows and columns until hitting a piece.
  */
-std::vector<std::pair<int, int>> ChessPieceRook::getMoveCandidates() {
-    std::vector<std::pair<int, int>> moves;
-    // Vertical & horizontal directions
-    // Move up/down
-    for (int direction : {-1, 1}) {
-        // Move along rows
-        for (int row = y + direction; row >= 0 && row < BOARDSIZE; row += direction) {
-            if (chessBoard->getBoard()[row][x]->getCode() == EMPTY) {
-                moves.push_back({row, x});
-            } else {
-                // Stop if we find a piece
-                break;
-            }
-        }
-        // Move along columns
-        for (int col = x + direction; col >= 0 && col < BOARDSIZE; col += direction) {
-            if (chessBoard->getBoard()[y][col]->getCode() == EMPTY) {
-                moves.push_back({y, col});
-            } else {
-                // Stop if we find a piece
-                break;
-            }
-        }
-    }
-
-    return moves;
+template <bool White>
+void ChessPieceRook<White>::getMoveCandidates(ChessBoard *board, int square, bool /*moved*/, MoveList &out, uint64_t targets) {
+    uint64_t occupied = board->getOccupancy();
+    appendRays(out, square, rookAttacks(square, occupied) & ~occupied & targets, rookDirections, 4);
 }
 
 /**
  * @brief  Rook attack candidates: same directions, but can include the square with an enemy piece.
- *         If 'all' is true, empty squares in the path are also returned.
- */
-std::vector<std::pair<int, int>> ChessPieceRook::getAttackCandidates(bool all) {
-    std::vector<std::pair<int, int>> attacks;
-    for (int direction : {-1, 1}) {
-        // Vertical (rows)
-        for (int row = y + direction; row >= 0 && row < BOARDSIZE; row += direction) {
-            ChessPieceBase* piece = chessBoard->getBoard()[row][x];
-            if (piece->getCode() != EMPTY) {
-                // If it's an enemy piece, we can attack it
-                if (piece->isWhite() != white) {
-                    attacks.push_back({row, x});
-                }
-                // Stop regardless of enemy or friend
-                break;
-            } else if (all) {
-                attacks.push_back({row, x});
-            }
-        }
-        // Horizontal (columns)
-        for (int col = x + direction; col >= 0 && col < BOARDSIZE; col += direction) {
-            ChessPieceBase* piece = chessBoard->getBoard()[y][col];
-            if (piece->getCode() != EMPTY) {
-                // If it's an enemy piece, we can attack it
-                if (piece->isWhite() != white) {
-                    attacks.push_back({y, col});
-                }
-                // Stop
-                break;
-            } else if (all) {
-                attacks.push_back({y, col});
-            }
-        }
-    }
-
-    return attacks;
+ *         If `All` is set, empty squares in the path are also returned.
+ */
+template <bool White>
+template <bool All>
+void ChessPieceRook<White>::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    appendRays(out, square, getAttackMask<All>(board, square) & targets, rookDirections, 4);
 }
 
-ChessPieceRook::~ChessPieceRook() {
-    if (log) {
-        log->log("ROOK DELETED");
-    }
+template <bool White>
+template <bool All>
+uint64_t ChessPieceRook<White>::getAttackMask(ChessBoard *board, int square) {
+    return rookAttacks(square, board->getOccupancy()) & attackTargets<White, All>(board);
 }
 
+
 //======================== ChessPieceBishop Methods ========================//
 
-ChessPieceBishop::ChessPieceBishop(
-    int x, int y, bool color, 
-    Logger *log, 
-    ChessBoard *board,
-    bool moved_
-) : ChessPieceBase(x, y, color, log, board, moved_) {
-    this->code = BISHOP;
-    this->playable = true;
-
-    if (log) {
-        log->log("BISHOP CREATED");
-    }
-}
 
 /**
  * @brief  Bishop moves diagonally until obstructed by a piece.
  *         Only squares that are EMPTY are returned for actual "moves".
- *         This implementation has a hard-coded maximum recursion depth, 
- *         but a typical approach would iterate over each diagonal direction.
- */
-std::vector<std::pair<int, int>> ChessPieceBishop::getMoveCandidates() {
-    std::vector<std::pair<int,int>> moves;
-    // Directions for diagonal movement: (+1,+1), (+1,-1), (-1,+1), (-1,-1)
-    static const int directions[4][2] = {
-        {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
-    };
-
-    for (auto &dir : directions) {
-        int row = y;
-        int col = x;
-        while (true) {
-            row += dir[0];
-            col += dir[1];
-            if (row < 0 || row >= BOARDSIZE ||
-                col < 0 || col >= BOARDSIZE)
-            {
-                break; // out of bounds
-            }
-            if (chessBoard->getBoard()[row][col]->getCode() == EMPTY) {
-                moves.push_back({row, col});
-            } else {
-                // We hit a piece, so no further squares in this direction.
-                break;
-            }
-        }
-    }
-
-    return moves;
+ */
+template <bool White>
+void ChessPieceBishop<White>::getMoveCandidates(ChessBoard *board, int square, bool /*moved*/, MoveList &out, uint64_t targets) {
+    uint64_t occupied = board->getOccupancy();
+    appendRays(out, square, bishopAttacks(square, occupied) & ~occupied & targets, bishopDirections, 4);
 }
 
 /**
  * @brief  Bishop attack candidates. 
- *         If 'all' is true, we also include empty squares in the diagonal paths.
- */
-std::vector<std::pair<int, int>> ChessPieceBishop::getAttackCandidates(bool all) {
-    std::vector<std::pair<int,int>> attacks;
-    static const int directions[4][2] = {
-        {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
-    };
-
-    for (auto &dir : directions) {
-        int row = y;
-        int col = x;
-        while (true) {
-            row += dir[0];
-            col += dir[1];
-            if (row < 0 || row >= BOARDSIZE ||
-                col < 0 || col >= BOARDSIZE)
-            {
-                break;
-            }
-            ChessPieceBase* piece = chessBoard->getBoard()[row][col];
-            if (piece->getCode() != EMPTY) {
-                // If it is an enemy, we can attack; then stop.
-                if (piece->isWhite() != white) {
-                    attacks.push_back({row, col});
-                }
-                break;
-            } else if (all) {
-                // Include empty squares if asked for
-                attacks.push_back({row, col});
-            }
-        }
-    }
-
-    return attacks;
+ *         If `All` is set, we also include empty squares in the diagonal paths.
+ */
+template <bool White>
+template <bool All>
+void ChessPieceBishop<White>::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    appendRays(out, square, getAttackMask<All>(board, square) & targets, bishopDirections, 4);
 }
 
-ChessPieceBishop::~ChessPieceBishop() {
-    if (log) {
-        log->log("BISHOP DELETED");
-    }
+template <bool White>
+template <bool All>
+uint64_t ChessPieceBishop<White>::getAttackMask(ChessBoard *board, int square) {
+    return bishopAttacks(square, board->getOccupancy()) & attackTargets<White, All>(board);
 }
 
+
 //======================== ChessPieceQueen Methods ========================//
 
-ChessPieceQueen::ChessPieceQueen(
-    int x, int y, 
-    bool color, 
-    Logger *log, 
-    ChessBoard *board,
-    bool moved_
-) : ChessPieceBase(x, y, color, log, board, moved_) {
-    this->code = QUEEN;
-    this->playable = true;
-
-    if (log) {
-        log->log("QUEEN CREATED");
-    }
-}
 
 /**
  * @brief  The Queen moves like a Rook + Bishop combined.
  */
-std::vector<std::pair<int, int>> ChessPieceQueen::getMoveCandidates() {
-    std::vector<std::pair<int,int>> moves;
-
-    // 1) Rook-like moves
-    //    Move up/down/left/right until blocked
-    for (int direction : {-1, 1}) {
-        // Vertical
-        for (int row = y + direction; row >= 0 && row < BOARDSIZE; row += direction) {
-            if (chessBoard->getBoard()[row][x]->getCode() == EMPTY) {
-                moves.push_back({row, x});
-            } else {
-                break;
-            }
-        }
-        // Horizontal
-        for (int col = x + direction; col >= 0 && col < BOARDSIZE; col += direction) {
-            if (chessBoard->getBoard()[y][col]->getCode() == EMPTY) {
-                moves.push_back({y, col});
-            } else {
-                break;
-            }
-        }
-    }
+template <bool White>
+void ChessPieceQueen<White>::getMoveCandidates(ChessBoard *board, int square, bool /*moved*/, MoveList &out, uint64_t targets) {
+    uint64_t occupied = board->getOccupancy();
+    uint64_t reach = queenAttacks(square, occupied) & ~occupied & targets;
 
-    // 2) Bishop-like moves
-    static const int directions[4][2] = {
-        {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
-    };
-
-    for (auto &dir : directions) {
-        int row = y;
-        int col = x;
-        while (true) {
-            row += dir[0];
-            col += dir[1];
-            if (row < 0 || row >= BOARDSIZE ||
-                col < 0 || col >= BOARDSIZE)
-            {
-                break;
-            }
-            if (chessBoard->getBoard()[row][col]->getCode() == EMPTY) {
-                moves.push_back({row, col});
-            } else {
-                break;
-            }
-        }
-    }
-
-    return moves;
+    // 1) Rook-like moves, 2) Bishop-like moves
+    appendRays(out, square, reach, rookDirections, 4);
+    appendRays(out, square, reach, bishopDirections, 4);
 }
 
 /**
  * @brief  Queen attack candidates (rook + bishop logic).
- * @param  all  If true, includes empty squares in paths.
- */
-std::vector<std::pair<int, int>> ChessPieceQueen::getAttackCandidates(bool all) {
-    std::vector<std::pair<int,int>> attacks;
-
-    // 1) Rook-like
-    for (int direction : {-1, 1}) {
-        // Vertical
-        for (int row = y + direction; row >= 0 && row < BOARDSIZE; row += direction) {
-            ChessPieceBase* piece = chessBoard->getBoard()[row][x];
-            if (piece->getCode() != EMPTY) {
-                if (piece->isWhite() != white) {
-                    attacks.push_back({row, x});
-                }
-                break;
-            } else if (all) {
-                attacks.push_back({row, x});
-            }
-        }
-        // Horizontal
-        for (int col = x + direction; col >= 0 && col < BOARDSIZE; col += direction) {
-            ChessPieceBase* piece = chessBoard->getBoard()[y][col];
-            if (piece->getCode() != EMPTY) {
-                if (piece->isWhite() != white) {
-                    attacks.push_back({y, col});
-                }
-                break;
-            } else if (all) {
-                attacks.push_back({y, col});
-            }
-        }
-    }
-
-    // 2) Bishop-like
-    static const int directions[4][2] = {
-        {1, 1}, {1, -1}, {-1, 1}, {-1, -1}
-    };
-
-    for (auto &dir : directions) {
-        int row = y;
-        int col = x;
-        while (true) {
-            row += dir[0];
-            col += dir[1];
-            if (row < 0 || row >= BOARDSIZE ||
-                col < 0 || col >= BOARDSIZE)
-            {
-                break;
-            }
-            ChessPieceBase* piece = chessBoard->getBoard()[row][col];
-            if (piece->getCode() != EMPTY) {
-                if (piece->isWhite() != white) {
-                    attacks.push_back({row, col});
-                }
-                break;
-            } else if (all) {
-                attacks.push_back({row, col});
-            }
-        }
-    }
-
-    return attacks;
+ * @tparam All  If true, includes empty squares in paths.
+ */
+template <bool White>
+template <bool All>
+void ChessPieceQueen<White>::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    uint64_t reach = getAttackMask<All>(board, square) & targets;
+    appendRays(out, square, reach, rookDirections, 4);
+    appendRays(out, square, reach, bishopDirections, 4);
 }
 
-ChessPieceQueen::~ChessPieceQueen() {
-    if (log) {
-        log->log("QUEEN DELETED");
-    }
+template <bool White>
+template <bool All>
+uint64_t ChessPieceQueen<White>::getAttackMask(ChessBoard *board, int square) {
+    return queenAttacks(square, board->getOccupancy()) & attackTargets<White, All>(board);
 }
 
+
 //======================== ChessPeiceKing Methods ========================//
 
-ChessPeiceKing::ChessPeiceKing(
-    int x, int y, 
-    bool color, 
-    Logger *log, 
-    ChessBoard *board,
-    bool moved_
-) : ChessPieceBase(x, y, color, log, board, moved_) {
-    this->code = KING;
-    this->playable = true;
-
-    if (log) {
-        log->log("KING CREATED");
-    }
+
+/**
+ * @brief  Squares of `row` from column `from` to column `to`, both included (from <= to).
+ */
+static uint64_t rowSpan(int row, int from, int to) {
+    return ((0xFFULL >> (7 - (to - from))) << from) << (row * BOARDSIZE);
+}
+
+/**
+ * @brief  Every square of column `col`.
+ */
+static uint64_t columnSpan(int col) {
+    return 0x0101010101010101ULL << col;
 }
 
 /**
@@ -712,66 +394,46 @@ ChessPeiceKing::ChessPeiceKing(
  *         Directions used in the original code: 0 (left), 1 (right), 2 (vertical?).
  *         Logic is somewhat unorthodox for "vertical" castling, but kept as in the original code.
  */
-static bool canCastle(ChessPeiceKing *king, int direction) {
-    ChessPieceBase ***board = king->getBoard();
-    bool white = king->isWhite();
-    int kingCol = king->getX();
-    int kingRow = king->getY();
+template <bool White>
+static bool canCastle(ChessBoard *chessBoard, int kingSquare, int direction) {
+    int kingCol = kingSquare % BOARDSIZE;
+    int kingRow = kingSquare / BOARDSIZE;
 
     switch (direction) {
     case 0: { // Castling with the left rook
-        // Rook is at row=7 * !white, col=0 according to the original code.
-        ChessPieceBase* rook = board[7 * (!white)][0];
-        if (rook->getCode() == ROOK &&
-            rook->isWhite() == white &&
-            !rook->hasMoved() &&
-            rook->canMoveTo({kingRow, kingCol - 1}))
+        // Rook is at row=7 * !White, col=0 according to the original code.
+        ChessPiece rook = chessBoard->getPiece(7 * !White, 0);
+        if (rook.getCode() == ROOK &&
+            rook.isWhite() == White &&
+            !rook.hasMoved() &&
+            rook.canMoveTo({kingRow, kingCol - 1}))
         {
             // Check if any square between the King and Rook is under check
-            int minCol = std::min(kingCol, 0);
-            int maxCol = std::max(kingCol, 0);
-            for (int col = minCol; col <= maxCol; ++col) {
-                if (ChessBoard::simplifiedEvaluateCheckMate(white, {kingRow, col}, board)) {
-                    return false;
-                }
-            }
-            return true;
+            return !(chessBoard->getAttackMap(!White) & rowSpan(kingRow, 0, kingCol));
         }
         return false;
     }
     case 1: { // Castling with the right rook
-        // Rook is at row=7 * !white, col=7
-        ChessPieceBase* rook = board[7 * (!white)][7];
-        if (rook->getCode() == ROOK &&
-            rook->isWhite() == white &&
-            !rook->hasMoved() &&
-            rook->canMoveTo({kingRow, kingCol + 1}))
+        // Rook is at row=7 * !White, col=7
+        ChessPiece rook = chessBoard->getPiece(7 * !White, 7);
+        if (rook.getCode() == ROOK &&
+            rook.isWhite() == White &&
+            !rook.hasMoved() &&
+            rook.canMoveTo({kingRow, kingCol + 1}))
         {
-            int minCol = std::min(kingCol, 7);
-            int maxCol = std::max(kingCol, 7);
-            for (int col = minCol; col <= maxCol; ++col) {
-                if (ChessBoard::simplifiedEvaluateCheckMate(white, {kingRow, col}, board)) {
-                    return false;
-                }
-            }
-            return true;
+            return !(chessBoard->getAttackMap(!White) & rowSpan(kingRow, kingCol, 7));
         }
         return false;
     }
     case 2: { // "Vertical" castling as introduced in the original code
-        ChessPieceBase* rook = board[7 * white][kingCol];
-        if (rook->getCode() == ROOK &&
-            rook->isWhite() == white &&
-            !rook->hasMoved() &&
-            rook->canMoveTo({kingRow + (2 * white - 1), kingCol}))
+        ChessPiece rook = chessBoard->getPiece(7 * White, kingCol);
+        if (rook.getCode() == ROOK &&
+            rook.isWhite() == White &&
+            !rook.hasMoved() &&
+            rook.canMoveTo({kingRow + (White ? 1 : -1), kingCol}))
         {
             // Check squares along the column for checks
-            for (int row = 0; row < BOARDSIZE; ++row) {
-                if (ChessBoard::simplifiedEvaluateCheckMate(white, {row, kingCol}, board)) {
-                    return false;
-                }
-            }
-            return true;
+            return !(chessBoard->getAttackMap(!White) & columnSpan(kingCol));
         }
         return false;
     }
@@ -784,86 +446,141 @@ static bool canCastle(ChessPeiceKing *king, int direction) {
  * @brief  Returns squares to which the King can move safely (not under check, and not adjacent to an enemy king).
  *         Also includes squares that represent possible castling moves, indicated in an unusual way.
  */
-std::vector<std::pair<int, int>> ChessPeiceKing::getMoveCandidates() {
-    std::vector<std::pair<int,int>> moves;
-
-    // King can move up to 1 square in any direction, excluding squares under check or near an opposing king
-    for (int row = y - 1; row <= y + 1; ++row) {
-        for (int col = x - 1; col <= x + 1; ++col) {
-            if (row >= 0 && row < BOARDSIZE &&
-                col >= 0 && col < BOARDSIZE &&
-                !(row == y && col == x))
-            {
-                // Check if the square is empty, not under check, and no nearby enemy king
-                if (chessBoard->getBoard()[row][col]->getCode() == EMPTY &&
-                    !ChessBoard::simplifiedEvaluateCheckMate(white, {row, col}, chessBoard->getBoard()) &&
-                    !isOpposingKingNearby(chessBoard->getBoard(), {row, col}, white))
-                {
-                    moves.push_back({row, col});
-                }
-            }
-        }
-    }
+template <bool White>
+void ChessPeiceKing<White>::getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out, uint64_t targets) {
+    // King can move up to 1 square in any direction, excluding squares under check or near an opposing king.
+    // Adjacent squares in ascending order are the same as a row-by-row scan of the 3x3 block.
+    uint64_t steps = kingAttacks(square) &
+                     ~board->getOccupancy() &
+                     ~opposingKingZone<White>(board) &
+                     ~board->getAttackMap(!White);
+    appendSquares(out, square, steps & targets);
 
     // If King has not moved, check castling possibilities
     if (!moved) {
-        if (canCastle(this, 0)) {
-            moves.push_back({(int)(7 * (!white)), 0});
+        constexpr int rookRow = 7 * !White;
+        int verticalTarget = squareOf(7 * White, square % BOARDSIZE);
+        if ((targets & squareBit(squareOf(rookRow, 0))) && canCastle<White>(board, square, 0)) {
+            out.push(square, squareOf(rookRow, 0));
         }
-        if (canCastle(this, 1)) {
-            moves.push_back({(int)(7 * (!white)), 7});
+        if ((targets & squareBit(squareOf(rookRow, 7))) && canCastle<White>(board, square, 1)) {
+            out.push(square, squareOf(rookRow, 7));
         }
-        if (canCastle(this, 2)) {
-            moves.push_back({(int)(7 * white), x});
+        if ((targets & squareBit(verticalTarget)) && canCastle<White>(board, square, 2)) {
+            out.push(square, verticalTarget);
         }
     }
-
-    return moves;
 }
 
 /**
  * @brief  Returns squares the King can attack (occupied by enemy pieces), 
  *         excluding those that would place him in check or next to an opposing King.
  */
-std::vector<std::pair<int, int>> ChessPeiceKing::getAttackCandidates(bool all) {
-    std::vector<std::pair<int,int>> attacks;
-
-    // The King can "attack" any of the 8 surrounding squares if it contains an enemy piece
-    // and is not under check or adjacent to an enemy king. If 'all' is true, empty squares 
-    // are also included.
-    for (int row = y - 1; row <= y + 1; ++row) {
-        for (int col = x - 1; col <= x + 1; ++col) {
-            if (row >= 0 && row < BOARDSIZE &&
-                col >= 0 && col < BOARDSIZE &&
-                !(row == y && col == x))
-            {
-                ChessPieceBase* piece = chessBoard->getBoard()[row][col];
-                if (piece->getCode() != EMPTY) {
-                    // The destination must not be under check, 
-                    // and not be adjacent to the enemy king
-                    if (!ChessBoard::simplifiedEvaluateCheckMate(white, {row, col}, chessBoard->getBoard()) &&
-                        piece->isWhite() != white &&
-                        !isOpposingKingNearby(chessBoard->getBoard(), {row, col}, white))
-                    {
-                        attacks.push_back({row, col});
-                    }
-                }
-                // If 'all' is set to true, we also include empty squares 
-                // that are not under check and not near an opposing king
-                else if (all &&
-                         !isOpposingKingNearby(chessBoard->getBoard(), {row, col}, white))
-                {
-                    attacks.push_back({row, col});
-                }
-            }
-        }
-    }
+template <bool White>
+template <bool All>
+void ChessPeiceKing<White>::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    appendSquares(out, square, getAttackMask<All>(board, square) & targets);
+}
 
+/**
+ * @brief  The King can "attack" any of the 8 surrounding squares if it contains an enemy piece
+ *         and is not under check or adjacent to an enemy king. If `All` is set, empty squares
+ *         that are not near an opposing king are also included.
+ */
+template <bool White>
+template <bool All>
+uint64_t ChessPeiceKing<White>::getAttackMask(ChessBoard *board, int square) {
+    uint64_t reach = kingAttacks(square) & ~opposingKingZone<White>(board);
+    uint64_t attacks = reach & board->getColorMask(!White) & ~board->getAttackMap(!White);
+    if constexpr (All) {
+        attacks |= reach & ~board->getOccupancy();
+    }
     return attacks;
 }
 
-ChessPeiceKing::~ChessPeiceKing() {
-    if (log) {
-        log->log("KING DELETED");
+
+//======================== ChessPieceBase Dispatch ========================//
+
+
+/**
+ * @brief  Reads the piece on `square` and hands over to the generator of its type.
+ *         Empty squares generate nothing.
+ */
+template <bool White>
+void ChessPieceBase::getMoveCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    auto value = board->getState().squares[square];
+    bool moved = squareMoved(value);
+    switch (squareCode(value)) {
+    case KING:   ChessPeiceKing<White>::getMoveCandidates(board, square, moved, out, targets);   break;
+    case QUEEN:  ChessPieceQueen<White>::getMoveCandidates(board, square, moved, out, targets);  break;
+    case ROOK:   ChessPieceRook<White>::getMoveCandidates(board, square, moved, out, targets);   break;
+    case BISHOP: ChessPieceBishop<White>::getMoveCandidates(board, square, moved, out, targets); break;
+    case KNIGHT: ChessPieceKnight<White>::getMoveCandidates(board, square, moved, out, targets); break;
+    case PAWN:   ChessPiecePawn<White>::getMoveCandidates(board, square, moved, out, targets);   break;
+    default:     break;
+    }
+}
+
+template <bool White, bool All>
+void ChessPieceBase::getAttackCandidates(ChessBoard *board, int square, MoveList &out, uint64_t targets) {
+    switch (squareCode(board->getState().squares[square])) {
+    case KING:   ChessPeiceKing<White>::template getAttackCandidates<All>(board, square, out, targets);   break;
+    case QUEEN:  ChessPieceQueen<White>::template getAttackCandidates<All>(board, square, out, targets);  break;
+    case ROOK:   ChessPieceRook<White>::template getAttackCandidates<All>(board, square, out, targets);   break;
+    case BISHOP: ChessPieceBishop<White>::template getAttackCandidates<All>(board, square, out, targets); break;
+    case KNIGHT: ChessPieceKnight<White>::template getAttackCandidates<All>(board, square, out, targets); break;
+    case PAWN:   ChessPiecePawn<White>::template getAttackCandidates<All>(board, square, out, targets);   break;
+    default:     break;
+    }
+}
+
+template <bool White, bool All>
+uint64_t ChessPieceBase::getAttackMask(ChessBoard *board, int square) {
+    switch (squareCode(board->getState().squares[square])) {
+    case KING:   return ChessPeiceKing<White>::template getAttackMask<All>(board, square);
+    case QUEEN:  return ChessPieceQueen<White>::template getAttackMask<All>(board, square);
+    case ROOK:   return ChessPieceRook<White>::template getAttackMask<All>(board, square);
+    case BISHOP: return ChessPieceBishop<White>::template getAttackMask<All>(board, square);
+    case KNIGHT: return ChessPieceKnight<White>::template getAttackMask<All>(board, square);
+    case PAWN:   return ChessPiecePawn<White>::template getAttackMask<All>(board, square);
+    default:     return 0;
+    }
+}
+
+uint64_t ChessPieceBase::getThreatMask(ChessPieceCode code, bool white, int square,
+                                       uint64_t occupancy, uint64_t enemies) {
+    uint64_t targets = enemies | ~occupancy;
+    switch (code) {
+    case QUEEN:  return queenAttacks(square, occupancy) & targets;
+    case ROOK:   return rookAttacks(square, occupancy) & targets;
+    case BISHOP: return bishopAttacks(square, occupancy) & targets;
+    case KNIGHT: return knightAttacks(square) & targets;
+    case PAWN:   return pawnAttacks(white, square) & enemies;
+    default:     return 0;
     }
 }
+
+void ChessPieceBase::appendAttackOrder(ChessPieceCode code, int square, uint64_t mask,
+                                       MoveList &out) {
+    switch (code) {
+    case QUEEN:
+        appendRays(out, square, mask, rookDirections, 4);
+        appendRays(out, square, mask, bishopDirections, 4);
+        break;
+    case ROOK:   appendRays(out, square, mask, rookDirections, 4);   break;
+    case BISHOP: appendRays(out, square, mask, bishopDirections, 4); break;
+    case KNIGHT: appendKnightSquares(out, square, mask);             break;
+    default:     appendSquares(out, square, mask);                   break;
+    }
+}
+
+template void ChessPieceBase::getMoveCandidates<true>(ChessBoard *, int, MoveList &, uint64_t);
+template void ChessPieceBase::getMoveCandidates<false>(ChessBoard *, int, MoveList &, uint64_t);
+template void ChessPieceBase::getAttackCandidates<true, true>(ChessBoard *, int, MoveList &, uint64_t);
+template void ChessPieceBase::getAttackCandidates<true, false>(ChessBoard *, int, MoveList &, uint64_t);
+template void ChessPieceBase::getAttackCandidates<false, true>(ChessBoard *, int, MoveList &, uint64_t);
+template void ChessPieceBase::getAttackCandidates<false, false>(ChessBoard *, int, MoveList &, uint64_t);
+template uint64_t ChessPieceBase::getAttackMask<true, true>(ChessBoard *, int);
+template uint64_t ChessPieceBase::getAttackMask<true, false>(ChessBoard *, int);
+template uint64_t ChessPieceBase::getAttackMask<false, true>(ChessBoard *, int);
+template uint64_t ChessPieceBase::getAttackMask<false, false>(ChessBoard *, int);
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "chess-bitboard.h"
+#include "chess-move-list.h"
 #include "chess-peice-codes.h"
 #include "logger.h"
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <vector>
@@ -12,61 +15,20 @@
  */
 #define BOARDSIZE 8
 
-/**
- * @brief The maximum allowed recursion depth (for example, in AI search).
- */
-#define MAXDEPTH 256
 class ChessBoard;
+class ChessPiece;
+
 /**
  * @class ChessPieceBase
- * @brief Base class for all chess pieces.
+ * @brief Move and attack rules of the piece types.
  *
- * This class provides common fields and methods for any chess piece:
- * piece code, color, status flags, coordinates, a logger instance, and a pointer 
- * to the board. It also declares virtual methods to retrieve possible moves and attacks.
+ * Nothing here holds state. The generators read the piece from the board's
+ * BoardState byte, switch once on its type and hand over to the generator of
+ * that type (ChessPiecePawn etc.), which is specialized at compile time on the
+ * color and, for attacks, on the `all` mode. The hot loops therefore carry no
+ * virtual calls and no color branches.
  */
 class ChessPieceBase {
-protected:
-  /**
-   * @brief The code of this piece (from ChessPieceCode enumeration).
-   */
-  ChessPieceCode code = NONE;
-
-  /**
-   * @brief Indicates whether the piece is white (true) or black (false).
-   */
-  bool white = true;
-
-  /**
-   * @brief Indicates whether the piece is currently playable (active).
-   */
-  bool playable = false;
-
-  /**
-   * @brief Indicates whether this piece has been moved at least once.
-   */
-  bool moved = false;
-
-  /**
-   * @brief Pointer to a logger instance for logging moves or events.
-   */
-  Logger *log = nullptr;
-
-  /**
-   * @brief Pointer to the board.
-   */
-  ChessBoard *chessBoard = nullptr;
-
-  /**
-   * @brief The current x-coordinate of the piece on the board.
-   */
-  int x = -1;
-
-  /**
-   * @brief The current y-coordinate of the piece on the board.
-   */
-  int y = -1;
-
 public:
   /**
    * @brief Returns the single-character symbol for a given piece code.
@@ -83,375 +45,257 @@ public:
   static ChessPieceCode getPieceCode(char chr);
 
   /**
-   * @brief Moves the piece to the specified board coordinates.
-   * @param dest A pair of integers representing the (x, y) coordinates.
+   * @brief Appends all possible move positions for the piece on `square`.
+   * @tparam White The color of that piece.
+   * @param board The board the piece stands on.
+   * @param square Index of the square, row * 8 + col.
+   * @param out The list receiving the moves (from `square`).
+   * @param targets Only moves ending on these squares are appended.
    */
-  void move(const std::pair<int, int> &dest);
+  template <bool White>
+  static void getMoveCandidates(ChessBoard *board, int square, MoveList &out,
+                                uint64_t targets);
 
   /**
-   * @brief Getter for the current x-coordinate of the piece.
-   * @return The current x-coordinate.
+   * @brief Appends all possible attack positions for the piece on `square`.
+   * @tparam White The color of that piece.
+   * @tparam All If true, considers every potential attack path or position.
    */
-  int getX() { return x; }
+  template <bool White, bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
 
   /**
-   * @brief Getter for the current y-coordinate of the piece.
-   * @return The current y-coordinate.
+   * @brief Retrieves the same squares as getAttackCandidates as a bitboard.
+   * @tparam White The color of that piece.
+   * @tparam All If true, considers every potential attack path or position.
+   * @return A mask of the attacked squares (bit = row * 8 + col).
    */
-  int getY() { return y; }
+  template <bool White, bool All>
+  static uint64_t getAttackMask(ChessBoard *board, int square);
 
   /**
-   * @brief Provides access to the board pointer.
-   * @return A triple-pointer to ChessPieceBase.
+   * @brief getAttackMask with `All` set for a piece on `square` of a position
+   *        given only by its occupancy and the squares of the other color, so a
+   *        position one move ahead can be asked without making the move.
+   *        En passant is left out. Kings are not covered, their mask depending
+   *        on the other side's attack map.
+   * @return The mask, or 0 for a king or an empty square.
    */
-  ChessPieceBase ***getBoard();
+  static uint64_t getThreatMask(ChessPieceCode code, bool white, int square,
+                                uint64_t occupancy, uint64_t enemies);
 
   /**
-   * @brief Provides access to the logger instance.
-   * @return A pointer to Logger.
+   * @brief Appends the squares of `mask`, from `square`, in the order
+   *        getAttackCandidates reports them for a piece of type `code`.
    */
-  Logger *getLogger() { return log; }
+  static void appendAttackOrder(ChessPieceCode code, int square, uint64_t mask,
+                                MoveList &out);
+};
 
+/**
+ * @class ChessPiece
+ * @brief The piece standing on one square of a board.
+ *
+ * A handle is only a board pointer and a square index, made on demand by
+ * ChessBoard::getPiece. Its accessors decode the square's byte, and its
+ * generators dispatch to the shared behavior of the piece type.
+ */
+class ChessPiece {
+public:
   /**
-   * @brief Indicates if the piece has moved at least once.
-   * @return True if moved, false otherwise.
+   * @brief Refers to the square `square` (row * 8 + col) of `chessBoard`.
    */
-  bool hasMoved() { return moved; }
+  ChessPiece(ChessBoard *chessBoard, int square)
+      : chessBoard(chessBoard), square(square) {}
 
   /**
-   * @brief Retrieves the code of this piece.
-   * @return The piece code.
+   * @brief Getter for the x-coordinate (column) of the piece.
    */
-  ChessPieceCode getCode();
+  int getX() const { return square % BOARDSIZE; }
 
   /**
-   * @brief Indicates if this is a white piece.
-   * @return True if white, false if black.
+   * @brief Getter for the y-coordinate (row) of the piece.
    */
-  bool isWhite();
+  int getY() const { return square / BOARDSIZE; }
 
   /**
-   * @brief Default constructor.
+   * @brief Index of the square, row * 8 + col.
    */
-  ChessPieceBase() = delete;
-
-
-  ChessPieceBase(int x, int y, bool color, Logger *log,
-    ChessBoard *board, bool moved_);
+  int getSquare() const { return square; }
 
   /**
-   * @brief Retrieves all possible move positions for this piece.
-   * @return A vector of (x, y) pairs representing valid moves.
+   * @brief Provides access to the board that owns this piece.
    */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() = 0;
+  ChessBoard *getChessBoard() const { return chessBoard; }
 
   /**
-   * @brief Retrieves all possible attack positions for this piece.
-   * @param all If true, considers every potential attack path or position.
-   * @return A vector of (x, y) pairs representing valid attacks.
+   * @brief Retrieves the code of this piece (EMPTY for an empty square).
    */
-  virtual std::vector<std::pair<int, int>> getAttackCandidates(bool all) = 0;
+  ChessPieceCode getCode() const;
 
   /**
-   * @brief Checks if the piece can move to a specific position.
-   * @param pnt The target (x, y) coordinates.
-   * @return True if moving to pnt is valid, false otherwise.
+   * @brief Indicates if this is a white piece. Empty squares are not white.
    */
-  virtual bool canMoveTo(const std::pair<int, int> &pnt);
+  bool isWhite() const;
 
   /**
-   * @brief Checks if the piece can attack a specific position.
-   * @param pnt The target (x, y) coordinates.
-   * @return True if attacking pnt is valid, false otherwise.
+   * @brief Indicates if the piece has moved at least once.
    */
-  virtual bool canAttack(const std::pair<int, int> &pnt);
+  bool hasMoved() const;
 
   /**
-   * @brief Returns a string representation of the piece for debugging or display.
-   * @return A string describing the piece.
+   * @brief Indicates if the piece is playable (not an empty square).
    */
-  std::string print();
+  bool isPlayable() const { return getCode() != EMPTY; }
 
   /**
-   * @brief Indicates if the piece is playable (not an empty placeholder).
-   * @return True if the piece can be used in the game, false otherwise.
+   * @brief Appends all possible move positions for this piece.
+   * @param out The list receiving the moves (from this piece's square).
+   * @param targets Only moves ending on these squares are appended.
    */
-  bool isPlayable();
-};
+  void getMoveCandidates(MoveList &out, uint64_t targets = ALL_SQUARES) const {
+    if (isWhite()) {
+      ChessPieceBase::getMoveCandidates<true>(chessBoard, square, out, targets);
+    } else {
+      ChessPieceBase::getMoveCandidates<false>(chessBoard, square, out, targets);
+    }
+  }
 
-/**
- * @class ChessPieceEmpty
- * @brief Represents an empty square on the chessboard.
- */
-class ChessPieceEmpty : public ChessPieceBase {
-public:
   /**
-   * @brief Constructs an empty piece at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
+   * @brief Appends all possible attack positions for this piece.
+   * @param all If true, considers every potential attack path or position.
+   * @param out The list receiving the attacks (from this piece's square).
+   * @param targets Only moves ending on these squares are appended.
    */
-  ChessPieceEmpty(int x, int y, Logger *log, ChessBoard *board);
+  void getAttackCandidates(bool all, MoveList &out, uint64_t targets = ALL_SQUARES) const {
+    if (isWhite()) {
+      all ? ChessPieceBase::getAttackCandidates<true, true>(chessBoard, square, out, targets)
+          : ChessPieceBase::getAttackCandidates<true, false>(chessBoard, square, out, targets);
+    } else {
+      all ? ChessPieceBase::getAttackCandidates<false, true>(chessBoard, square, out, targets)
+          : ChessPieceBase::getAttackCandidates<false, false>(chessBoard, square, out, targets);
+    }
+  }
 
   /**
-   * @brief Retrieves possible moves for an empty square (none).
-   * @return An empty vector of coordinates.
+   * @brief Retrieves the same squares as getAttackCandidates as a bitboard.
+   * @param all If true, considers every potential attack path or position.
    */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
+  uint64_t getAttackMask(bool all) const {
+    if (isWhite()) {
+      return all ? ChessPieceBase::getAttackMask<true, true>(chessBoard, square)
+                 : ChessPieceBase::getAttackMask<true, false>(chessBoard, square);
+    }
+    return all ? ChessPieceBase::getAttackMask<false, true>(chessBoard, square)
+               : ChessPieceBase::getAttackMask<false, false>(chessBoard, square);
+  }
 
   /**
-   * @brief Retrieves possible attack positions for an empty square (none).
-   * @param all If true, considers all possible positions (still none).
-   * @return An empty vector of coordinates.
+   * @brief Checks if the piece can move to a specific position.
+   * @param pnt The target (row, col) coordinates.
+   * @return True if moving to pnt is valid, false otherwise.
    */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
+  bool canMoveTo(const std::pair<int, int> &pnt) const;
 
   /**
-   * @brief Checks if an empty square can move to a position (it cannot).
-   * @param pnt The target position.
-   * @return Always false.
+   * @brief Checks if the piece can attack a specific position.
+   * @param pnt The target (row, col) coordinates.
+   * @return True if attacking pnt is valid, false otherwise.
    */
-  virtual bool canMoveTo(const std::pair<int, int> &pnt) override;
+  bool canAttack(const std::pair<int, int> &pnt) const;
 
   /**
-   * @brief Checks if an empty square can attack a position (it cannot).
-   * @param pnt The target position.
-   * @return Always false.
+   * @brief Returns a string representation of the piece for debugging or display.
+   * @return A string describing the piece.
    */
-  virtual bool canAttack(const std::pair<int, int> &pnt) override;
+  std::string print() const;
 
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPieceEmpty();
+private:
+  ChessBoard *chessBoard;
+  int square;
 };
 
 /**
  * @class ChessPiecePawn
- * @brief Represents a pawn piece.
+ * @brief Generators of a pawn of color `White`.
  */
-class ChessPiecePawn : public ChessPieceBase {
+template <bool White> class ChessPiecePawn {
 public:
-  /**
-   * @brief Constructs a pawn at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param color True for white, false for black.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the pawn has moved before.
-   */
-  ChessPiecePawn(int x, int y, bool color, Logger *log,
-                 ChessBoard *board, bool moved_ = false);
-
-  /**
-   * @brief Retrieves possible moves for this pawn.
-   * @return A vector of (x, y) coordinates representing valid moves.
-   */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
-
-  /**
-   * @brief Retrieves possible attack positions for this pawn.
-   * @param all If true, includes all possible attack squares.
-   * @return A vector of (x, y) coordinates representing valid attacks.
-   */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
-
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPiecePawn();
+  static void getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out,
+                                uint64_t targets);
+  template <bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
+  template <bool All> static uint64_t getAttackMask(ChessBoard *board, int square);
 };
 
 /**
  * @class ChessPieceKnight
- * @brief Represents a knight piece.
+ * @brief Generators of a knight of color `White`.
  */
-class ChessPieceKnight : public ChessPieceBase {
+template <bool White> class ChessPieceKnight {
 public:
-  /**
-   * @brief Constructs a knight at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param color True for white, false for black.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the knight has moved before.
-   */
-  ChessPieceKnight(int x, int y, bool color, Logger *log,
-                   ChessBoard *board, bool moved_ = false);
-
-  /**
-   * @brief Retrieves possible moves for the knight (in an L shape).
-   * @return A vector of (x, y) coordinates representing valid moves.
-   */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
-
-  /**
-   * @brief Retrieves possible attack positions for the knight.
-   * @param all If true, includes all possible positions in an L shape.
-   * @return A vector of (x, y) coordinates representing valid attacks.
-   */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
-
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPieceKnight();
+  static void getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out,
+                                uint64_t targets);
+  template <bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
+  template <bool All> static uint64_t getAttackMask(ChessBoard *board, int square);
 };
 
 /**
  * @class ChessPieceRook
- * @brief Represents a rook piece.
+ * @brief Generators of a rook of color `White`.
  */
-class ChessPieceRook : public ChessPieceBase {
+template <bool White> class ChessPieceRook {
 public:
-  /**
-   * @brief Constructs a rook at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param color True for white, false for black.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the rook has moved before.
-   */
-  ChessPieceRook(int x, int y, bool color, Logger *log,
-                 ChessBoard *board, bool moved_ = false);
-
-  /**
-   * @brief Retrieves possible moves for the rook (horizontal and vertical).
-   * @return A vector of (x, y) coordinates representing valid moves.
-   */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
-
-  /**
-   * @brief Retrieves possible attack positions for the rook.
-   * @param all If true, includes all possible squares along ranks and files.
-   * @return A vector of (x, y) coordinates representing valid attacks.
-   */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
-
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPieceRook();
+  static void getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out,
+                                uint64_t targets);
+  template <bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
+  template <bool All> static uint64_t getAttackMask(ChessBoard *board, int square);
 };
 
 /**
  * @class ChessPieceBishop
- * @brief Represents a bishop piece.
+ * @brief Generators of a bishop of color `White`.
  */
-class ChessPieceBishop : public ChessPieceBase {
+template <bool White> class ChessPieceBishop {
 public:
-  /**
-   * @brief Constructs a bishop at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param color True for white, false for black.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the bishop has moved before.
-   */
-  ChessPieceBishop(int x, int y, bool color, Logger *log,
-                   ChessBoard *board, bool moved_ = false);
-
-  /**
-   * @brief Retrieves possible moves for the bishop (diagonal directions).
-   * @return A vector of (x, y) coordinates representing valid moves.
-   */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
-
-  /**
-   * @brief Retrieves possible attack positions for the bishop.
-   * @param all If true, includes all possible squares along diagonal lines.
-   * @return A vector of (x, y) coordinates representing valid attacks.
-   */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
-
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPieceBishop();
+  static void getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out,
+                                uint64_t targets);
+  template <bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
+  template <bool All> static uint64_t getAttackMask(ChessBoard *board, int square);
 };
 
 /**
  * @class ChessPieceQueen
- * @brief Represents a queen piece.
+ * @brief Generators of a queen of color `White`.
  */
-class ChessPieceQueen : public ChessPieceBase {
+template <bool White> class ChessPieceQueen {
 public:
-  /**
-   * @brief Constructs a queen at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param color True for white, false for black.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the queen has moved before.
-   */
-  ChessPieceQueen(int x, int y, bool color, Logger *log,
-                  ChessBoard *board, bool moved_ = false);
-
-  /**
-   * @brief Retrieves possible moves for the queen (combining rook and bishop moves).
-   * @return A vector of (x, y) coordinates representing valid moves.
-   */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
-
-  /**
-   * @brief Retrieves possible attack positions for the queen.
-   * @param all If true, includes all squares along ranks, files, and diagonals.
-   * @return A vector of (x, y) coordinates representing valid attacks.
-   */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
-
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPieceQueen();
+  static void getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out,
+                                uint64_t targets);
+  template <bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
+  template <bool All> static uint64_t getAttackMask(ChessBoard *board, int square);
 };
 
 /**
  * @class ChessPeiceKing
- * @brief Represents a king piece.
+ * @brief Generators of a king of color `White`.
  */
-class ChessPeiceKing : public ChessPieceBase {
+template <bool White> class ChessPeiceKing {
 public:
-  /**
-   * @brief Constructs a king at the given coordinates.
-   * @param x The x-coordinate.
-   * @param y The y-coordinate.
-   * @param color True for white, false for black.
-   * @param log Pointer to the logger instance.
-   * @param board Pointer to the board array.
-   * @param moved_ Indicates whether the king has moved before.
-   */
-  ChessPeiceKing(int x, int y, bool color, Logger *log, 
-                 ChessBoard *board, bool moved_ = false);
-
-  /**
-   * @brief Retrieves possible moves for the king (one square in any direction).
-   * @return A vector of (x, y) coordinates representing valid moves.
-   */
-  virtual std::vector<std::pair<int, int>> getMoveCandidates() override;
-
-  /**
-   * @brief Retrieves possible attack positions for the king.
-   * @param all If true, includes all squares adjacent to the king.
-   * @return A vector of (x, y) coordinates representing valid attacks.
-   */
-  virtual std::vector<std::pair<int, int>>
-  getAttackCandidates(bool all) override;
-
-  /**
-   * @brief Destructor.
-   */
-  ~ChessPeiceKing();
+  static void getMoveCandidates(ChessBoard *board, int square, bool moved, MoveList &out,
+                                uint64_t targets);
+  template <bool All>
+  static void getAttackCandidates(ChessBoard *board, int square, MoveList &out,
+                                  uint64_t targets);
+  template <bool All> static uint64_t getAttackMask(ChessBoard *board, int square);
 };
@@ -0,0 +1,79 @@
+#include "chess-perft.h"
+#include "chess-thread-pool.h"
+#include <chrono>
+#include <exception>
+#include <future>
+#include <stdexcept>
+
+/**
+ * @brief Leaf nodes `depth` plies below the current position.
+ *        The last ply is not played out: its moves are counted as generated,
+ *        the generator only producing legal moves.
+ */
+static uint64_t countNodes(ChessBoard *board, bool white, int depth) {
+    if (depth == 0) {
+        return 1;
+    }
+
+    MoveList moves;
+    board->generateLegalMoves(white, moves);
+    if (depth == 1) {
+        return moves.size();
+    }
+
+    uint64_t nodes = 0;
+    UndoRecord undo;
+    for (PackedMove move : moves) {
+        board->makeMove(unpackMove(move), undo);
+        nodes += countNodes(board, !white, depth - 1);
+        board->unmakeMove(undo);
+    }
+    return nodes;
+}
+
+Perft_Result runPerft(ChessBoard *board, bool white, int depth, bool divide) {
+    if (depth < 0 || depth > MAXDEPTH) {
+        throw std::invalid_argument("DEPTH OUT OF RANGE");
+    }
+
+    Perft_Result result;
+    auto start = std::chrono::steady_clock::now();
+
+    if (depth > 1 || (divide && depth > 0)) {
+        // Every root move is a task of the thread pool, on a board of its own
+        MoveList moves;
+        board->generateLegalMoves(white, moves);
+        std::vector<std::future<uint64_t>> counts;
+        for (PackedMove move : moves) {
+            counts.push_back(threadPool.submit([board, white, depth, move]() {
+                ChessBoard copy(board);
+                UndoRecord undo;
+                copy.makeMove(unpackMove(move), undo);
+                return countNodes(&copy, !white, depth - 1);
+            }));
+        }
+        // Every task has to be done before the board may go, so the first error waits
+        std::exception_ptr error;
+        for (int i = 0; i < moves.size(); ++i) {
+            try {
+                uint64_t nodes = threadPool.wait(counts[i]);
+                if (divide) {
+                    result.divide.push_back({moves[i], nodes});
+                }
+                result.nodes += nodes;
+            } catch (...) {
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    } else {
+        result.nodes = countNodes(board, white, depth);
+    }
+
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
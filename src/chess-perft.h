@@ -0,0 +1,46 @@
+#pragma once
+
+#include "chess-board.h"
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * @file   chess-perft.h
+ * @brief  Leaf node counting (perft) over the engine's own move rules.
+ *
+ * Perft walks the tree of legal moves with the same generator and the same
+ * makeMove/unmakeMove the search uses, so it covers every rule of this variant:
+ * the vertical castling, en passant by the last move and promotion to a queen.
+ * Equal counts before and after a generator change show the change kept the
+ * move set; the nodes per second measure its speed. The root moves are counted
+ * in parallel on the thread pool.
+ */
+
+/**
+ * @struct Perft_Result
+ * @brief Outcome of one perft run.
+ */
+struct Perft_Result {
+  uint64_t nodes = 0;   ///< Leaf nodes at the requested depth.
+  double seconds = 0.0; ///< Wall time of the run.
+  std::vector<std::pair<PackedMove, uint64_t>> divide; ///< Per root move, if asked for.
+
+  /**
+   * @brief Leaf nodes counted per second of wall time.
+   */
+  uint64_t nodesPerSecond() const {
+    return seconds > 0.0 ? uint64_t(nodes / seconds) : nodes;
+  }
+};
+
+/**
+ * @brief Counts the leaf nodes `depth` plies below the board's position.
+ * @param board The position; it is left as it was found.
+ * @param white The side to move first.
+ * @param depth Plies to walk, 0 counts the position itself.
+ * @param divide If true, also reports the count below each root move, in generation order.
+ * @throws std::invalid_argument if depth is negative or above MAXDEPTH; an
+ *         error below a root move once every root move is done.
+ */
+Perft_Result runPerft(ChessBoard *board, bool white, int depth, bool divide);
@@ -0,0 +1,451 @@
+#include "chess-search.h"
+#include "chess-transposition.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+/**
+ * @brief Larger than any score, so every real score beats it.
+ */
+static const float INFINITE_SCORE = std::numeric_limits<float>::infinity();
+
+/**
+ * @brief Half width of the first root window around the last iteration's value.
+ */
+static const float ASPIRATION_WINDOW = 200.0f;
+
+/**
+ * @brief Past this half width a failed root window is opened all the way on that side.
+ */
+static const float ASPIRATION_LIMIT = 4000.0f;
+
+/**
+ * @brief Where node counts stop growing instead of overflowing.
+ */
+static const uint64_t NODE_CEILING = std::numeric_limits<uint64_t>::max() / 2;
+
+/**
+ * @brief a * b, held at NODE_CEILING.
+ */
+static uint64_t saturatingProduct(uint64_t a, uint64_t b) {
+    if (b != 0 && a > NODE_CEILING / b) {
+        return NODE_CEILING;
+    }
+    return a * b;
+}
+
+/**
+ * @brief Counts clearHistory calls; a thread's Move_History from an older count is stale.
+ */
+static std::atomic<unsigned> historyEpoch{0};
+
+/**
+ * @brief The Move_History of the calling thread, emptied first if clearHistory
+ *        was called since it was last used.
+ */
+static Move_History& threadHistory() {
+    static thread_local Move_History history = {};
+    unsigned epoch = historyEpoch.load(std::memory_order_relaxed);
+    if (history.epoch != epoch) {
+        history = Move_History{};
+        history.epoch = epoch;
+    }
+    return history;
+}
+
+void AlphaBetaSearch::clearHistory() {
+    ++historyEpoch;
+}
+
+AlphaBetaSearch::AlphaBetaSearch(ChessBoard* board, uint64_t nodeBudget, Deadline deadline,
+                                 int minimumDepth)
+    : board(board),
+      history(threadHistory()),
+      arena(size_t(MAX_SEARCH_PLY + 1) * MoveList::CAPACITY),
+      budget(nodeBudget),
+      deadline(deadline),
+      minimumDepth(std::min(minimumDepth, MAX_SEARCH_PLY)) {}
+
+/**
+ * @brief Mirrors the shape of the beam: the root has the best `difficulty` moves
+ *        searched, each of those nodes its best `difficulty` replies, and from
+ *        there on the width drops by one per ply.
+ */
+uint64_t AlphaBetaSearch::beamNodeBudget(int difficulty, int maxDepth, int branching) {
+    auto width = [&](int beam) {
+        return uint64_t(std::min(std::max(beam, 1), branching));
+    };
+
+    uint64_t total = 1;
+    uint64_t level = 1;
+    for (int depth = 1; depth <= maxDepth; ++depth) {
+        level = saturatingProduct(level, width(difficulty - std::max(depth - 2, 0)));
+        total = std::min(total + level, NODE_CEILING);
+    }
+    return total;
+}
+
+void AlphaBetaSearch::scoreMoves(const MoveList& moves, Move_Candidate* out) {
+    int count = 0;
+    for (PackedMove packed : moves) {
+        Move move = unpackMove(packed);
+        float score = board->scoreMove(move);
+
+        // Insertion keeps equal scores in generation order
+        int k = count++;
+        while (k > 0 && out[k - 1].dScore < score) {
+            out[k] = out[k - 1];
+            --k;
+        }
+        out[k] = {move, score};
+    }
+}
+
+/**
+ * @brief True for a capture or a promotion, the moves ordered by dScore alone.
+ */
+static bool isTactical(ChessBoard* board, const Move& move) {
+    const BoardState& state = board->getState();
+    uint8_t mover = state.squares[squareOf(move.start.first, move.start.second)];
+    uint8_t target = state.squares[squareOf(move.end.first, move.end.second)];
+    if (squareCode(target) != EMPTY && squareWhite(target) != squareWhite(mover)) {
+        return true;
+    }
+    return squareCode(mover) == PAWN && move.end.first == 7 * squareWhite(mover);
+}
+
+void AlphaBetaSearch::orderMoves(Move_Candidate* moves, int count, bool white, int ply) {
+    const PackedMove* killers = history.killers[std::min(ply, MAX_SEARCH_PLY)];
+    // Sort keys: the move's class in the high half, the inverted history in the low one
+    uint32_t keys[MoveList::CAPACITY];
+    for (int i = 0; i < count; ++i) {
+        PackedMove packed = packMove(moves[i].move);
+        if (isTactical(board, moves[i].move)) {
+            keys[i] = 0;
+        } else if (packed == killers[0]) {
+            keys[i] = 1u << 16;
+        } else if (packed == killers[1]) {
+            keys[i] = 2u << 16;
+        } else {
+            int score = history.history[white][moveFrom(packed)][moveTo(packed)];
+            keys[i] = (3u << 16) | uint32_t(Move_History::HISTORY_MAX - score);
+        }
+    }
+
+    // Insertion keeps equal keys in dScore order
+    for (int i = 1; i < count; ++i) {
+        Move_Candidate move = moves[i];
+        uint32_t key = keys[i];
+        int k = i;
+        while (k > 0 && key < keys[k - 1]) {
+            moves[k] = moves[k - 1];
+            keys[k] = keys[k - 1];
+            --k;
+        }
+        moves[k] = move;
+        keys[k] = key;
+    }
+}
+
+/**
+ * @brief Moves a history score towards +-HISTORY_MAX by `bonus`, the less the closer it is.
+ */
+static void adjustHistory(int& score, int bonus) {
+    score += bonus - score * std::abs(bonus) / Move_History::HISTORY_MAX;
+}
+
+void AlphaBetaSearch::updateHistory(bool white, int depth, int ply, PackedMove cutoff,
+                                    const PackedMove* tried, int triedCount) {
+    if (ply <= MAX_SEARCH_PLY && history.killers[ply][0] != cutoff) {
+        history.killers[ply][1] = history.killers[ply][0];
+        history.killers[ply][0] = cutoff;
+    }
+
+    // Deeper cutoffs weigh more; the quiet moves that did not cut lose as much
+    int bonus = std::min(depth * depth, Move_History::HISTORY_MAX);
+    adjustHistory(history.history[white][moveFrom(cutoff)][moveTo(cutoff)], bonus);
+    for (int i = 0; i < triedCount; ++i) {
+        adjustHistory(history.history[white][moveFrom(tried[i])][moveTo(tried[i])], -bonus);
+    }
+}
+
+void AlphaBetaSearch::updatePrincipalVariation(int ply, PackedMove move) {
+    pvTable[ply][0] = move;
+    std::copy(pvTable[ply + 1], pvTable[ply + 1] + pvLength[ply + 1], pvTable[ply] + 1);
+    pvLength[ply] = pvLength[ply + 1] + 1;
+}
+
+void AlphaBetaSearch::makeHelper(const std::atomic<bool>* stop, int index) {
+    stopSignal = stop;
+    firstDepth = 2 + index % 2;
+}
+
+bool AlphaBetaSearch::outOfBudget() {
+    if (stopSignal) {
+        stopped = stopSignal->load(std::memory_order_relaxed);
+        return stopped;
+    }
+    // The first iteration always finishes, so there is a move to fall back on
+    bool budgetSpent = nodes >= budget && completedDepth >= minimumDepth;
+    if ((budgetSpent || deadlinePassed(deadline)) && completedDepth > 0) {
+        stopped = true;
+    }
+    return stopped;
+}
+
+/**
+ * @brief Moves the candidate matching `hashMove` to the front, keeping the rest in order.
+ */
+static void promoteHashMove(Move_Candidate* candidates, int count, PackedMove hashMove) {
+    if (hashMove == 0) {
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        if (packMove(candidates[i].move) == hashMove) {
+            std::rotate(candidates, candidates + i, candidates + i + 1);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Plies taken off the search of the move at `index` of a node's move order.
+ *        The first moves and every move out of check are searched in full, and
+ *        the reduced search still keeps at least the last ply.
+ */
+static int lateMoveReduction(int index, int depth, bool inCheck) {
+    if (inCheck || depth < 3 || index < 3) {
+        return 0;
+    }
+    int reduction = int(0.75 + std::log(double(depth)) * std::log(double(index)) / 2.25);
+    return std::min(std::max(reduction, 1), depth - 2);
+}
+
+/**
+ * @brief The largest score below `bound`: a window from it to `bound` holds no
+ *        score, so a search in it only tells whether the value reaches `bound`.
+ */
+static float nullWindowBelow(float bound) {
+    return std::nextafter(bound, -INFINITE_SCORE);
+}
+
+float AlphaBetaSearch::negamax(bool white, int depth, int ply, float alpha, float beta) {
+    pvLength[ply] = 0;
+    ++nodes;
+    if (outOfBudget()) {
+        return 0.0f;
+    }
+
+    // Only a node with scores inside its window can be on the principal variation
+    bool pvNode = beta > std::nextafter(alpha, INFINITE_SCORE);
+    uint64_t key = board->getKey(white);
+    TT_Entry entry;
+    PackedMove hashMove = 0;
+    if (transpositionTable.probe(key, entry)) {
+        hashMove = entry.move;
+        // A principal variation node is searched anyway, so its line is complete
+        if (!pvNode && entry.depth >= depth &&
+            (entry.bound == TT_EXACT ||
+             (entry.bound == TT_LOWER && entry.score >= beta) ||
+             (entry.bound == TT_UPPER && entry.score <= alpha))) {
+            return entry.score;
+        }
+    }
+
+    // Last ply: the best immediate score and the captures after it, as the beam's leaves
+    if (depth == 1) {
+        PackedMove bestMove;
+        float best = board->quiescence(white, alpha, beta, quiescencePlies[ALPHA_BETA],
+                                       &bestMove);
+        if (bestMove) {
+            pvTable[ply][0] = bestMove;
+            pvLength[ply] = 1;
+        }
+        TT_Bound bound = best <= alpha ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT;
+        transpositionTable.store(key, 1, bound, best, bestMove);
+        return best;
+    }
+
+    Check_Masks check;
+    MoveList moves;
+    board->generateLegalMoves(white, moves, &check);
+    if (moves.empty()) {
+        return check.kingAttacked ? Mate : Pate;
+    }
+
+    CandidateArena::Frame frame(arena, moves.size());
+    Move_Candidate* scored = frame.data;
+    scoreMoves(moves, scored);
+    orderMoves(scored, moves.size(), white, ply);
+    promoteHashMove(scored, moves.size(), hashMove);
+
+    float originalAlpha = alpha;
+    float best = -INFINITE_SCORE;
+    PackedMove bestMove = 0;
+    PackedMove quiets[MoveList::CAPACITY]; // Quiet moves searched so far
+    int quietCount = 0;
+    for (int i = 0; i < moves.size(); ++i) {
+        const Move_Candidate& candidate = scored[i];
+        bool quiet = !isTactical(board, candidate.move);
+        UndoRecord undo;
+        board->makeMove(candidate.move, undo);
+        // Our value is dScore - reply; keep the reply's window in step with ours.
+        // The first move is searched with the full window. Every later one is
+        // first only tested against alpha with a null window, less deeply if it
+        // is far down the order, and searched again in full if it beats alpha.
+        float replyAlpha = candidate.dScore - beta;
+        float replyBeta = candidate.dScore - alpha;
+        float value;
+        if (i == 0) {
+            value = candidate.dScore - negamax(!white, depth - 1, ply + 1, replyAlpha, replyBeta);
+        } else {
+            int reduction = lateMoveReduction(i, depth, check.kingAttacked);
+            value = candidate.dScore - negamax(!white, depth - 1 - reduction, ply + 1,
+                                               nullWindowBelow(replyBeta), replyBeta);
+            if (reduction && value > alpha && !stopped) {
+                value = candidate.dScore - negamax(!white, depth - 1, ply + 1,
+                                                   nullWindowBelow(replyBeta), replyBeta);
+            }
+            if (value > alpha && value < beta && !stopped) {
+                value = candidate.dScore -
+                        negamax(!white, depth - 1, ply + 1, replyAlpha, replyBeta);
+            }
+        }
+        board->unmakeMove(undo);
+        if (stopped) {
+            return 0.0f;
+        }
+
+        if (value > best) {
+            best = value;
+            bestMove = packMove(candidate.move);
+            if (best > alpha) {
+                alpha = best;
+                updatePrincipalVariation(ply, bestMove);
+                if (alpha >= beta) {
+                    if (quiet) {
+                        updateHistory(white, depth, ply, bestMove, quiets, quietCount);
+                    }
+                    break;
+                }
+            }
+        }
+        if (quiet) {
+            quiets[quietCount++] = packMove(candidate.move);
+        }
+    }
+
+    TT_Bound bound = best <= originalAlpha ? TT_UPPER : best >= beta ? TT_LOWER : TT_EXACT;
+    transpositionTable.store(key, depth, bound, best, bestMove);
+    return best;
+}
+
+float AlphaBetaSearch::searchRoot(bool white, Move_Candidate* root, int count, int depth,
+                                  float low, float high, int& bestIndex) {
+    float bestValue = -INFINITE_SCORE;
+    bestIndex = 0;
+    for (int i = 0; i < count; ++i) {
+        const Move_Candidate& candidate = root[i];
+        // value = dScore - worth * reply lies between alpha and high only for
+        // replies between replyAlpha and replyBeta
+        float alpha = std::max(low, bestValue);
+        float replyAlpha = -INFINITE_SCORE;
+        float replyBeta = INFINITE_SCORE;
+        if (worth > 0.0f) {
+            replyAlpha = (candidate.dScore - high) / worth;
+            replyBeta = (candidate.dScore - alpha) / worth;
+        }
+
+        UndoRecord undo;
+        board->makeMove(candidate.move, undo);
+        float reply;
+        if (i == 0) {
+            reply = negamax(!white, depth - 1, 1, replyAlpha, replyBeta);
+        } else {
+            reply = negamax(!white, depth - 1, 1, nullWindowBelow(replyBeta), replyBeta);
+            float value = candidate.dScore - worth * reply;
+            if (value > alpha && value < high && !stopped) {
+                reply = negamax(!white, depth - 1, 1, replyAlpha, replyBeta);
+            }
+        }
+        board->unmakeMove(undo);
+        if (stopped) {
+            break;
+        }
+
+        float value = candidate.dScore - worth * reply;
+        if (value > bestValue) {
+            bestValue = value;
+            bestIndex = i;
+            rootLine[0] = packMove(candidate.move);
+            std::copy(pvTable[1], pvTable[1] + pvLength[1], rootLine + 1);
+            rootLineLength = pvLength[1] + 1;
+            if (bestValue >= high) {
+                break;
+            }
+        }
+    }
+    return bestValue;
+}
+
+Move AlphaBetaSearch::findBestMove(bool white) {
+    MoveList moves;
+    board->generateLegalMoves(white, moves);
+    if (moves.empty()) {
+        return {{-1, -1}, {-1, -1}};
+    }
+
+    CandidateArena::Frame frame(arena, moves.size());
+    Move_Candidate* root = frame.data;
+    int count = moves.size();
+    ++nodes;
+    scoreMoves(moves, root);
+    // A line of an earlier search may have passed through this position
+    TT_Entry entry;
+    if (transpositionTable.probe(board->getKey(white), entry)) {
+        promoteHashMove(root, count, entry.move);
+    }
+    completedDepth = 1;
+    completedScore = root[0].dScore;
+    principalVariation.assign(1, root[0].move);
+
+    for (int depth = firstDepth; depth <= MAX_SEARCH_PLY; ++depth) {
+        // Past the first iteration the value is looked for close to the last
+        // one; a window it falls outside of is widened on that side and searched again
+        bool aspirate = completedDepth >= firstDepth;
+        float delta = ASPIRATION_WINDOW;
+        float low = aspirate ? completedScore - delta : -INFINITE_SCORE;
+        float high = aspirate ? completedScore + delta : INFINITE_SCORE;
+        float bestValue;
+        int bestIndex;
+        while (true) {
+            bestValue = searchRoot(white, root, count, depth, low, high, bestIndex);
+            if (stopped || (bestValue > low && bestValue < high)) {
+                break;
+            }
+            delta *= 4.0f;
+            bool open = delta > ASPIRATION_LIMIT;
+            if (bestValue <= low) {
+                low = open ? -INFINITE_SCORE : completedScore - delta;
+            } else {
+                high = open ? INFINITE_SCORE : completedScore + delta;
+            }
+        }
+        if (stopped) {
+            break;
+        }
+
+        // The next iteration searches the best move first
+        std::rotate(root, root + bestIndex, root + bestIndex + 1);
+        completedDepth = depth;
+        completedScore = bestValue;
+        principalVariation.clear();
+        for (int i = 0; i < rootLineLength; ++i) {
+            principalVariation.push_back(unpackMove(rootLine[i]));
+        }
+    }
+
+    return root[0].move;
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "chess-board.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file   chess-search.h
+ * @brief  Alpha-beta (negamax) search, the alternative to the beam search of
+ *         ChessBoard::getBestMove.
+ */
+
+/**
+ * @brief Deepest ply the alpha-beta search goes to.
+ */
+#define MAX_SEARCH_PLY 64
+
+/**
+ * @struct Move_History
+ * @brief What the searches of one thread learned about quiet moves: the moves
+ *        that caused a beta cutoff at each ply (killers) and, per side, a score
+ *        for every start and end square pair (butterfly history). Kept from one
+ *        search to the next; see AlphaBetaSearch::clearHistory.
+ */
+struct Move_History {
+  /**
+   * @brief Bound of a history score; updates shrink towards it, so it is never passed.
+   */
+  static const int HISTORY_MAX = 16384;
+
+  PackedMove killers[MAX_SEARCH_PLY + 1][2]; ///< Newest first, 0 if empty.
+  int history[2][64][64];                    ///< [white][from][to], within +-HISTORY_MAX.
+  unsigned epoch;                            ///< The clearHistory count it was filled under.
+};
+
+/**
+ * @class AlphaBetaSearch
+ * @brief Negamax search with alpha-beta pruning over the beam search's scores.
+ *
+ * A line is scored the way recursiveSubroutine scores it: the mover's 1-ply
+ * dScore minus the best the opponent gets from the position after it, with Mate
+ * or Pate for a side left without moves and ChessBoard::quiescence on the last
+ * ply. At the root the reply is weighted by `worth`, as in getBestMove. Unlike the
+ * beam no move is dropped: every move is searched, best dScore first, and
+ * branches that cannot change the result are cut off. Below the root a node
+ * searches its hash move first, then its captures and promotions by dScore,
+ * then the killer moves of its ply, then the other quiet moves by their
+ * history score; the Move_History behind the last two belongs to the thread
+ * and outlives the search. Moves late in that order are searched less deeply
+ * unless that shallower look shows them beating the best line so far (late
+ * move reductions). Only the first move of a node is searched with the full
+ * window; every other one is first tested against the best so far with a null
+ * window and searched in full only if it passes (principal variation search).
+ * Every searched position goes into the transposition table; a hit searched
+ * deep enough ends the node early, except on the principal variation.
+ *
+ * The search deepens one ply at a time within a node budget, a node being one
+ * searched position, as one recursiveSubroutine call is for the beam, and an
+ * optional deadline. The budget does not stop it short of a minimum depth. Each iteration past the first starts with a root window
+ * around the value of the one before (aspiration) and widens it if the value
+ * falls outside. Once the budget or the deadline runs out the unfinished
+ * iteration is dropped and the best move and line of the last finished one are kept.
+ *
+ * Searches of the same position on several threads cooperate through the
+ * transposition table alone (Lazy SMP): helpers fill it with positions the main
+ * search then finds already searched, and their own results are dropped.
+ */
+class AlphaBetaSearch {
+public:
+  /**
+   * @brief Prepares a search of `board`, which is left as it was found.
+   * @param board The position to search.
+   * @param nodeBudget How many nodes the search may spend.
+   * @param deadline When the search has to stop.
+   * @param minimumDepth Iterations the search finishes whatever the budget;
+   *        only the deadline cuts them short.
+   */
+  AlphaBetaSearch(ChessBoard *board, uint64_t nodeBudget, Deadline deadline = NO_DEADLINE,
+                  int minimumDepth = 1);
+
+  /**
+   * @brief The move the deepest finished iteration found best.
+   * @param white The side to move.
+   * @return The move, or {{-1, -1}, {-1, -1}} if the side has none.
+   */
+  Move findBestMove(bool white);
+
+  /**
+   * @brief Nodes spent so far.
+   */
+  uint64_t getNodes() const { return nodes; }
+
+  /**
+   * @brief Plies of the deepest finished iteration.
+   */
+  int getCompletedDepth() const { return completedDepth; }
+
+  /**
+   * @brief Value of the best move found by the deepest finished iteration.
+   */
+  float getCompletedScore() const { return completedScore; }
+
+  /**
+   * @brief The line the deepest finished iteration expects, starting with the
+   *        best move; it ends early where the rest was cut off.
+   */
+  const std::vector<Move> &getPrincipalVariation() const { return principalVariation; }
+
+  /**
+   * @brief Makes this search a Lazy SMP helper: it ignores its budget and
+   *        deadline and stops once `stop` is set. Odd helpers start one ply
+   *        deeper, so the threads are not all on the same iteration.
+   * @param stop Set when the main search is done.
+   * @param index The helper's number, from 1.
+   */
+  void makeHelper(const std::atomic<bool> *stop, int index);
+
+  /**
+   * @brief Positions the beam search visits at a difficulty, for a given number
+   *        of moves per position; used to give both engines the same budget.
+   */
+  static uint64_t beamNodeBudget(int difficulty, int maxDepth, int branching);
+
+  /**
+   * @brief Makes every thread forget its killers and history before its next
+   *        search; for a new game.
+   */
+  static void clearHistory();
+
+private:
+  /**
+   * @brief Value of the position for the side to move, `depth` plies deep and
+   *        `ply` plies from the root.
+   *        Fail-soft: a result <= alpha or >= beta is a bound only.
+   */
+  float negamax(bool white, int depth, int ply, float alpha, float beta);
+
+  /**
+   * @brief Makes and scores every move of `moves` into `out`, best dScore first;
+   *        equal scores keep the generation order.
+   */
+  void scoreMoves(const MoveList &moves, Move_Candidate *out);
+
+  /**
+   * @brief Reorders moves scored by scoreMoves for a node `ply` plies deep:
+   *        captures and promotions keep their dScore order, the killers follow,
+   *        then the remaining moves by history, equal ones in dScore order.
+   */
+  void orderMoves(Move_Candidate *moves, int count, bool white, int ply);
+
+  /**
+   * @brief Records the quiet move `cutoff` as the reason for a beta cutoff at
+   *        `ply`, `depth` plies deep, and counts the quiet `tried` moves before it
+   *        against their history.
+   */
+  void updateHistory(bool white, int depth, int ply, PackedMove cutoff,
+                     const PackedMove *tried, int triedCount);
+
+  /**
+   * @brief One iteration over the root moves for values between `low` and `high`.
+   *        Fail-soft: a result <= low or >= high is a bound only, and a move
+   *        reaching `high` ends the iteration. Fills rootLine with the best move's line.
+   * @param bestIndex Receives the index of the best move.
+   */
+  float searchRoot(bool white, Move_Candidate *root, int count, int depth, float low,
+                   float high, int &bestIndex);
+
+  /**
+   * @brief Makes `move` followed by the line found below it the line of `ply`.
+   */
+  void updatePrincipalVariation(int ply, PackedMove move);
+
+  /**
+   * @brief Sets `stopped` once the deadline has passed or, past minimumDepth,
+   *        the budget is spent, unless no iteration has finished yet.
+   * @return `stopped`.
+   */
+  bool outOfBudget();
+
+  ChessBoard *board;     ///< The searched position, restored after every move.
+  Move_History &history; ///< The killers and history of the searching thread.
+  CandidateArena arena;  ///< The scored moves of every node on the current path.
+  uint64_t budget;       ///< Nodes the search may spend.
+  Deadline deadline;     ///< When the search has to stop.
+  int minimumDepth;      ///< Depth the budget cannot stop the search short of.
+  const std::atomic<bool> *stopSignal = nullptr; ///< Set for a helper; see makeHelper.
+  int firstDepth = 2;    ///< Depth of the first iteration past the root scoring.
+  uint64_t nodes = 0;    ///< Nodes spent.
+  bool stopped = false;  ///< Set once the budget ran out; unwinds the iteration.
+  int completedDepth = 0;
+  float completedScore = 0.0f;
+  std::vector<Move> principalVariation; ///< The line of the deepest finished iteration.
+  PackedMove pvTable[MAX_SEARCH_PLY + 1][MAX_SEARCH_PLY + 1]; ///< Line found below each ply.
+  int pvLength[MAX_SEARCH_PLY + 1] = {};                       ///< Length of each pvTable line.
+  PackedMove rootLine[MAX_SEARCH_PLY + 1];                     ///< Line of the best root move so far.
+  int rootLineLength = 0;
+};
@@ -0,0 +1,131 @@
+#include "chess-thread-pool.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Workers start only once a program sizes the pool
+ThreadPool threadPool(1);
+
+/**
+ * @brief Index of the calling thread's queue if it is a worker of `ownerPool`.
+ */
+static thread_local const ThreadPool *ownerPool = nullptr;
+static thread_local int ownQueue = -1;
+
+ThreadPool::ThreadPool(int threads) {
+    start(std::max(threads, 1));
+}
+
+ThreadPool::~ThreadPool() {
+    stop();
+}
+
+int ThreadPool::defaultThreads() {
+    return std::max(1, int(std::thread::hardware_concurrency()));
+}
+
+void ThreadPool::resize(int threads) {
+    if (threads <= 0) {
+        throw std::invalid_argument("THREAD COUNT MUST BE POSITIVE");
+    }
+    stop();
+    start(threads);
+}
+
+void ThreadPool::start(int threads) {
+    stopping = false;
+    // Tasks from outside need a queue even when there are no workers
+    int count = std::max(threads - 1, 1);
+    queues.clear();
+    for (int i = 0; i < count; ++i) {
+        queues.emplace_back(new Worker_Queue);
+    }
+    for (int i = 0; i < threads - 1; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+void ThreadPool::stop() {
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Without workers whatever is left runs here
+    std::function<void()> task;
+    while (take(task)) {
+        task();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    int index = (ownerPool == this) ? ownQueue : int(nextQueue++ % queues.size());
+    {
+        std::lock_guard<std::mutex> guard(queues[index]->lock);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        ++pending;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::take(std::function<void()> &task) {
+    int own = (ownerPool == this) ? ownQueue : -1;
+    if (own >= 0) {
+        Worker_Queue &queue = *queues[own];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+            --pending;
+            return true;
+        }
+    }
+
+    int count = int(queues.size());
+    for (int offset = 1; offset <= count; ++offset) {
+        int victim = (std::max(own, 0) + offset) % count;
+        if (victim == own) {
+            continue;
+        }
+        Worker_Queue &queue = *queues[victim];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+            --pending;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    if (!take(task)) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::workerLoop(int index) {
+    ownerPool = this;
+    ownQueue = index;
+    while (true) {
+        if (runPendingTask()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wake.wait(guard, [this]() { return stopping || pending > 0; });
+        if (stopping && pending == 0) {
+            return;
+        }
+    }
+}
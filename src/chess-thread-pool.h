@@ -0,0 +1,132 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @file   chess-thread-pool.h
+ * @brief  The process-wide pool of engine threads.
+ */
+
+/**
+ * @class ThreadPool
+ * @brief Work-stealing pool: a queue per worker thread, tasks handed out as futures.
+ *
+ * A task submitted by a worker goes onto that worker's queue, one submitted
+ * from outside onto the queues in turn. A worker runs its own newest task first
+ * and, with its queue empty, steals the oldest task of another; with nothing
+ * to run anywhere it sleeps until a task is submitted.
+ *
+ * The pool counts the thread that waits for the results as one of its threads:
+ * `wait` runs queued tasks until the awaited one is done, so a pool of one
+ * thread has no workers and runs everything in the caller.
+ */
+class ThreadPool {
+public:
+  /**
+   * @brief Starts a pool of `threads` threads; see resize.
+   */
+  explicit ThreadPool(int threads = defaultThreads());
+
+  /**
+   * @brief Lets the workers finish the queued tasks and joins them.
+   */
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  /**
+   * @brief One thread per core.
+   */
+  static int defaultThreads();
+
+  /**
+   * @brief Replaces the workers with `threads - 1` new ones, after the old ones
+   *        have finished the queued tasks.
+   * @throws std::invalid_argument if threads is not positive.
+   */
+  void resize(int threads);
+
+  /**
+   * @brief Threads the pool runs tasks on, the waiting caller included.
+   */
+  int getThreads() const { return int(workers.size()) + 1; }
+
+  /**
+   * @brief Queues `task`.
+   * @return The future of its result; an exception of the task is rethrown by get.
+   */
+  template <typename Task>
+  std::future<typename std::invoke_result<Task>::type> submit(Task task) {
+    typedef typename std::invoke_result<Task>::type Result;
+    auto job = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> future = job->get_future();
+    push([job]() { (*job)(); });
+    return future;
+  }
+
+  /**
+   * @brief Runs queued tasks until `future` is ready, then returns its result.
+   */
+  template <typename Result> Result wait(std::future<Result> &future) {
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (!runPendingTask()) {
+        future.wait();
+      }
+    }
+    return future.get();
+  }
+
+private:
+  /**
+   * @struct Worker_Queue
+   * @brief The tasks submitted to one worker.
+   */
+  struct Worker_Queue {
+    std::mutex lock;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void push(std::function<void()> task);
+
+  /**
+   * @brief Takes a task, from the own queue if called by a worker, else stolen.
+   */
+  bool take(std::function<void()> &task);
+
+  /**
+   * @brief Runs one queued task, if there is one.
+   * @return False if there was none.
+   */
+  bool runPendingTask();
+
+  void workerLoop(int index);
+
+  void start(int threads);
+
+  void stop();
+
+  std::vector<std::unique_ptr<Worker_Queue>> queues;
+  std::vector<std::thread> workers;
+  std::atomic<int> pending{0};   ///< Tasks queued and not yet taken.
+  std::atomic<unsigned> nextQueue{0}; ///< Queue of the next task from outside.
+  std::mutex sleepLock;
+  std::condition_variable wake;
+  bool stopping = false;         ///< Guarded by sleepLock.
+};
+
+/**
+ * @brief The pool of this process, used by the searches and perft. It starts
+ *        with the calling thread alone; each program's main resizes it once.
+ */
+extern ThreadPool threadPool;
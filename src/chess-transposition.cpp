@@ -0,0 +1,94 @@
+#include "chess-transposition.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+TranspositionTable transpositionTable;
+
+/**
+ * @brief Layout of Slot::data: score bits 0-31, move 32-43, depth 44-51,
+ *        bound 52-53, generation 54-61.
+ */
+static uint64_t packEntry(float score, PackedMove move, int depth, TT_Bound bound,
+                          uint8_t generation) {
+    uint32_t scoreBits;
+    std::memcpy(&scoreBits, &score, sizeof scoreBits);
+    return uint64_t(scoreBits) |
+           (uint64_t(move & 0xFFF) << 32) |
+           (uint64_t(std::min(std::max(depth, 0), 255)) << 44) |
+           (uint64_t(bound) << 52) |
+           (uint64_t(generation) << 54);
+}
+
+static TT_Bound entryBound(uint64_t data) { return TT_Bound((data >> 52) & 3); }
+
+static int entryDepth(uint64_t data) { return int((data >> 44) & 0xFF); }
+
+static uint8_t entryGeneration(uint64_t data) { return uint8_t(data >> 54); }
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    if (megabytes == 0) {
+        throw std::invalid_argument("HASH SIZE MUST BE POSITIVE");
+    }
+    if (megabytes > MAX_MEGABYTES) {
+        throw std::invalid_argument("HASH SIZE MUST NOT EXCEED " + std::to_string(MAX_MEGABYTES) +
+                                    " MB");
+    }
+
+    size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= megabytes * 1024 * 1024) {
+        count *= 2;
+    }
+    slots.reset(new Slot[count]);
+    mask = count - 1;
+    this->megabytes = megabytes;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i <= mask; ++i) {
+        slots[i].check.store(0, std::memory_order_relaxed);
+        slots[i].data.store(0, std::memory_order_relaxed);
+    }
+    generation = 0;
+}
+
+bool TranspositionTable::probe(uint64_t key, TT_Entry& out) const {
+    const Slot& slot = slots[key & mask];
+    uint64_t data = slot.data.load(std::memory_order_relaxed);
+    uint64_t check = slot.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || entryBound(data) == TT_NONE) {
+        return false;
+    }
+
+    uint32_t scoreBits = uint32_t(data);
+    std::memcpy(&out.score, &scoreBits, sizeof scoreBits);
+    out.move = PackedMove((data >> 32) & 0xFFF);
+    out.depth = entryDepth(data);
+    out.bound = entryBound(data);
+    return true;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, TT_Bound bound, float score,
+                               PackedMove move) {
+    Slot& slot = slots[key & mask];
+    uint64_t old = slot.data.load(std::memory_order_relaxed);
+    bool samePosition = (slot.check.load(std::memory_order_relaxed) ^ old) == key;
+    if (!samePosition && entryBound(old) != TT_NONE &&
+        entryGeneration(old) == generation && entryDepth(old) > depth) {
+        return;
+    }
+
+    // Keep the old best move when the new search of the position found none
+    if (samePosition && move == 0) {
+        move = PackedMove((old >> 32) & 0xFFF);
+    }
+    uint64_t data = packEntry(score, move, depth, bound, generation);
+    slot.data.store(data, std::memory_order_relaxed);
+    slot.check.store(key ^ data, std::memory_order_relaxed);
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "chess-move-list.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @file   chess-transposition.h
+ * @brief  Fixed-size table of searched positions, shared by all search threads.
+ */
+
+/**
+ * @brief How an entry's score relates to the true value of its position.
+ */
+enum TT_Bound : uint8_t {
+  TT_NONE,  ///< Slot never written.
+  TT_EXACT, ///< The value itself.
+  TT_LOWER, ///< The value is at least the score (the search failed high).
+  TT_UPPER, ///< The value is at most the score (the search failed low).
+};
+
+/**
+ * @struct TT_Entry
+ * @brief One position as the table hands it out.
+ */
+struct TT_Entry {
+  float score;     ///< Score found for the side to move.
+  PackedMove move; ///< Best move found, 0 if none.
+  int depth;       ///< Plies the score was searched to.
+  TT_Bound bound;  ///< What kind of score it is.
+};
+
+/**
+ * @class TranspositionTable
+ * @brief Lock-free table from Zobrist key to TT_Entry.
+ *
+ * A slot is two 64-bit words: the packed entry and the key XOR-ed with it.
+ * Threads read and write both words without locks; a slot torn by two writers
+ * fails the key check on the next probe and reads as a miss. Entries outlive a
+ * search, so the next move of the same game starts from what this one found;
+ * newSearch ages them so they give way to fresh ones.
+ *
+ * resize and clear must not run while a search is using the table.
+ */
+class TranspositionTable {
+public:
+  /**
+   * @brief Size used unless the command line or the protocol sets another.
+   */
+  static const size_t DEFAULT_MEGABYTES = 16;
+
+  /**
+   * @brief Largest size the table may be given.
+   */
+  static const size_t MAX_MEGABYTES = 4096;
+
+  /**
+   * @brief Allocates the table; see resize.
+   */
+  explicit TranspositionTable(size_t megabytes = DEFAULT_MEGABYTES);
+
+  /**
+   * @brief Reallocates the table empty, with the largest power-of-two slot
+   *        count that fits into `megabytes` (at least one slot). If the
+   *        memory cannot be had, the old table stays as it was.
+   * @throws std::invalid_argument if megabytes is 0 or above MAX_MEGABYTES.
+   * @throws std::bad_alloc if the memory cannot be had.
+   */
+  void resize(size_t megabytes);
+
+  /**
+   * @brief Forgets every entry.
+   */
+  void clear();
+
+  /**
+   * @brief Marks the entries written so far as belonging to an older search.
+   */
+  void newSearch() { generation = uint8_t(generation + 1); }
+
+  /**
+   * @brief Looks the position up.
+   * @param key The position's Zobrist key.
+   * @param out Receives the entry on a hit.
+   * @return True on a hit.
+   */
+  bool probe(uint64_t key, TT_Entry &out) const;
+
+  /**
+   * @brief Records a searched position. The slot keeps a deeper entry of the
+   *        current search over a shallower one of another position.
+   */
+  void store(uint64_t key, int depth, TT_Bound bound, float score, PackedMove move);
+
+  /**
+   * @brief Size of the table in megabytes, as last requested.
+   */
+  size_t getMegabytes() const { return megabytes; }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> check; ///< key ^ data.
+    std::atomic<uint64_t> data;  ///< The packed entry.
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  size_t mask = 0;      ///< Slot count - 1; the count is a power of two.
+  size_t megabytes = 0;
+  uint8_t generation = 0;
+};
+
+/**
+ * @brief The table of this process, used by every search.
+ */
+extern TranspositionTable transpositionTable;
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "chess-board-state.h"
+#include <cstdint>
+
+/**
+ * @file   chess-zobrist.h
+ * @brief  Random keys whose XOR identifies a position (Zobrist hashing).
+ *
+ * A position's key is the XOR of one key per occupied square, picked by the
+ * square's whole byte (piece code, color and moved flag, so castling rights of
+ * both the normal and the vertical kind are covered), the key of the en passant
+ * file if a pawn just made a double step, and the side-to-move key when White
+ * is to move. Changing a square or the last move only XORs the old key out and
+ * the new one in.
+ */
+
+/**
+ * @struct ZobristKeys
+ * @brief The key tables, generated at compile time.
+ */
+struct ZobristKeys {
+  uint64_t squares[32][64]; ///< Per square byte value and square; 0 for empty squares.
+  uint64_t enPassant[8];    ///< Per column of the pawn that just made a double step.
+  uint64_t whiteToMove;     ///< Mixed in when White is to move.
+};
+
+/**
+ * @brief Next value of the splitmix64 sequence started from `state`.
+ */
+constexpr uint64_t splitMix64(uint64_t &state) {
+  uint64_t value = (state += 0x9E3779B97F4A7C15ULL);
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+/**
+ * @brief Builds the ZobristKeys from a fixed seed; only ever evaluated by the compiler.
+ */
+constexpr ZobristKeys makeZobristKeys() {
+  ZobristKeys keys{};
+  uint64_t seed = 0x2545F4914F6CDD1DULL;
+
+  for (int value = 0; value < 32; ++value) {
+    for (int square = 0; square < 64; ++square) {
+      uint64_t key = splitMix64(seed);
+      keys.squares[value][square] = (value & SQUARE_CODE) == EMPTY ? 0 : key;
+    }
+  }
+  for (int col = 0; col < 8; ++col) {
+    keys.enPassant[col] = splitMix64(seed);
+  }
+  keys.whiteToMove = splitMix64(seed);
+  return keys;
+}
+
+/**
+ * @brief The key tables, placed in read-only data.
+ */
+inline constexpr ZobristKeys ZOBRIST = makeZobristKeys();
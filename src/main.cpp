@@ -1,7 +1,54 @@
 #include "IOhandler.h"
-int main() {
+#include "chess-thread-pool.h"
+#include "chess-transposition.h"
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+static const char *USAGE = "usage: chess-server [--hash <megabytes>] [--threads <count>]";
+
+int main(int argc, char **argv) {
+  // --hash <megabytes> sizes the transposition table before the first search,
+  // --threads <count> the thread pool searches run on, one thread per core by default
+  int megabytes = int(TranspositionTable::DEFAULT_MEGABYTES);
+  int threads = ThreadPool::defaultThreads();
+  for (int i = 1; i < argc; ++i) {
+    bool hash = std::strcmp(argv[i], "--hash") == 0;
+    if (!hash && std::strcmp(argv[i], "--threads") != 0) {
+      std::cerr << "UNKNOWN ARGUMENT " << argv[i] << std::endl << USAGE << std::endl;
+      return 1;
+    }
+    if (i + 1 >= argc) {
+      std::cerr << argv[i] << " NEEDS A NUMBER" << std::endl << USAGE << std::endl;
+      return 1;
+    }
+    try {
+      (hash ? megabytes : threads) = std::stoi(argv[++i]);
+    } catch (std::logic_error &) {
+      std::cerr << argv[i - 1] << " WAS GIVEN WRONG: " << argv[i] << std::endl
+                << USAGE << std::endl;
+      return 1;
+    }
+  }
+  if (megabytes <= 0) {
+    std::cerr << "HASH SIZE MUST BE POSITIVE" << std::endl;
+    return 1;
+  }
+  try {
+    if (size_t(megabytes) != transpositionTable.getMegabytes()) {
+      transpositionTable.resize(size_t(megabytes));
+    }
+    threadPool.resize(threads);
+  } catch (std::invalid_argument &arg) {
+    std::cerr << arg.what() << std::endl;
+    return 1;
+  } catch (std::bad_alloc &) {
+    std::cerr << "NOT ENOUGH MEMORY FOR THE HASH TABLE" << std::endl;
+    return 1;
+  }
 
   IOhandler handler(&std::cout, &std::cin);
   handler.mainLoop();
   return 0;
-}
\ No newline at end of file
+}
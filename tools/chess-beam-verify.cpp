@@ -0,0 +1,250 @@
+/**
+ * @file   chess-beam-verify.cpp
+ * @brief  Checks the beam search against a plain reimplementation and against
+ *         what the original program chose.
+ *
+ * Usage: chess-beam-verify <corpus> [--baseline <results>] [--threads <n>]
+ *
+ * Every line of the corpus is a position the way `prestart` reads it, and the
+ * AI moves for the side it plays after `prestart`: the one opposite to the last
+ * digit. Blank lines and lines starting with '#' are skipped.
+ *
+ * The reference below is the beam in its plainest form: a copy of the board for
+ * every candidate, std::vector candidate lists kept by insertion, no
+ * transposition table, one thread, the plain best immediate score at the
+ * horizon. It shares the move generator and performMove with the engine, so it
+ * cannot see a change in those; the baseline results can. They hold, line by
+ * line in the same order and skipping the same lines, the move and score the
+ * original program recorded for each position, in the form `describe` writes.
+ *
+ * The engine runs as it ships. ChessBoard::getBeamMove has to pick the same move
+ * with a bit-identical score as the reference, and as the baseline if given, on
+ * every line, once with an empty transposition table and once with the table
+ * the first search left. The exit status is non-zero otherwise.
+ *
+ * This file is built with floating-point contraction off, so the reference
+ * rounds every product and difference on its own, as the engine does.
+ */
+
+#include "chess-board.h"
+#include "chess-peice-codes.h"
+#include "chess-thread-pool.h"
+#include "chess-transposition.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Keeps the best `difficulty` candidates, best first; a candidate goes
+ *        before the first one it strictly beats.
+ */
+static void insertCandidate(std::vector<Move_Candidate> &top, const Move_Candidate &candidate,
+                            int difficulty) {
+  if (top.empty()) {
+    top.push_back(candidate);
+    return;
+  }
+  for (int k = 0; k < (int)top.size(); ++k) {
+    if (top[k].dScore < candidate.dScore) {
+      top.insert(top.begin() + k, candidate);
+      if ((int)top.size() > difficulty) {
+        top.pop_back();
+      }
+      return;
+    }
+  }
+  if ((int)top.size() < difficulty) {
+    top.push_back(candidate);
+  }
+}
+
+/**
+ * @brief The candidates of a position, each scored on a fresh copy of the board.
+ */
+static std::vector<Move_Candidate> scoreCandidates(ChessBoard *board, bool white, int difficulty,
+                                                   Check_Masks *check) {
+  MoveList moves;
+  board->generateLegalMoves(white, moves, check);
+  std::vector<Move_Candidate> top;
+  for (PackedMove packed : moves) {
+    Move move = unpackMove(packed);
+    ChessBoard copy(board);
+    insertCandidate(top, {move, copy.performMove(move, nullptr, true)}, difficulty);
+  }
+  return top;
+}
+
+/**
+ * @brief recursiveSubroutine as first written. `worth` is squared on every ply
+ *        and passed along unused, as it was.
+ */
+static float referenceSubroutine(ChessBoard *board, bool white, int difficulty, int depth,
+                                 int maxDepth, float worth) {
+  Check_Masks check;
+  std::vector<Move_Candidate> top = scoreCandidates(board, white, difficulty, &check);
+
+  if (depth == maxDepth) {
+    if (!top.empty()) {
+      return top.front().dScore;
+    }
+    return check.kingAttacked ? Mate : Pate;
+  }
+
+  float maxScore = 0.0f;
+  bool firstEval = true;
+  for (const Move_Candidate &candidate : top) {
+    ChessBoard copy(board);
+    copy.performMove(candidate.move, nullptr, true);
+    float dScore = candidate.dScore - referenceSubroutine(&copy, !white, difficulty - 1,
+                                                          depth + 1, maxDepth, worth * worth);
+    if (firstEval || dScore > maxScore) {
+      maxScore = dScore;
+      firstEval = false;
+    }
+  }
+  if (top.empty()) {
+    return check.kingAttacked ? Mate : Pate;
+  }
+  return maxScore;
+}
+
+/**
+ * @brief getBestMove as first written, with the score of the chosen move.
+ */
+static Move_Candidate referenceBestMove(ChessBoard *board, bool white) {
+  int difficulty = board->getDifficulty();
+  int maxDepth = board->getSearchDepth();
+  std::vector<Move_Candidate> top = scoreCandidates(board, white, difficulty, nullptr);
+  if (top.empty()) {
+    return {{{-1, -1}, {-1, -1}}, 0.0f};
+  }
+  if (maxDepth <= 0) {
+    return top.front();
+  }
+
+  float maxScore = 0.0f;
+  int bestIndex = 0;
+  for (int i = 0; i < (int)top.size(); ++i) {
+    ChessBoard copy(board);
+    copy.performMove(top[i].move, nullptr, true);
+    float reply = worth * referenceSubroutine(&copy, !white, difficulty, 1, maxDepth,
+                                              worth * worth);
+    float finalScore = top[i].dScore - reply;
+    if (i == 0 || finalScore > maxScore) {
+      maxScore = finalScore;
+      bestIndex = i;
+    }
+  }
+  return {top[bestIndex].move, maxScore};
+}
+
+/**
+ * @brief The move as White types it and the score's exact bits, or the error.
+ */
+static std::string describe(const Move_Candidate &result) {
+  uint32_t bits;
+  std::memcpy(&bits, &result.dScore, sizeof bits);
+  char buffer[64];
+  std::snprintf(buffer, sizeof buffer, "%d%d:%d%d %.9g (0x%08x)", result.move.start.second,
+                result.move.start.first, result.move.end.second, result.move.end.first,
+                result.dScore, bits);
+  return buffer;
+}
+
+/**
+ * @brief Runs `search` and describes its result, or the exception it threw.
+ */
+template <typename Search> static std::string outcome(Search search) {
+  try {
+    return describe(search());
+  } catch (std::exception &ex) {
+    return std::string("ERROR ") + ex.what();
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: chess-beam-verify <corpus> [--baseline <results>] [--threads <n>]"
+              << std::endl;
+    return 2;
+  }
+  const char *baselinePath = nullptr;
+  int threads = ThreadPool::defaultThreads();
+  for (int i = 2; i + 1 < argc; ++i) {
+    if (std::strcmp(argv[i], "--threads") == 0) {
+      threads = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--baseline") == 0) {
+      baselinePath = argv[++i];
+    }
+  }
+
+  threadPool.resize(threads);
+
+  std::ifstream corpus(argv[1]);
+  if (!corpus) {
+    std::cerr << "CANNOT OPEN " << argv[1] << std::endl;
+    return 2;
+  }
+  std::ifstream baseline;
+  if (baselinePath) {
+    baseline.open(baselinePath);
+    if (!baseline) {
+      std::cerr << "CANNOT OPEN " << baselinePath << std::endl;
+      return 2;
+    }
+  }
+
+  int positions = 0;
+  int mismatches = 0;
+  std::string line;
+  while (std::getline(corpus, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    ++positions;
+
+    ChessBoard board(nullptr, 1);
+    board.makeBoardFromString(line);
+    bool white = !(line.back() - '0');
+
+    std::string expected = outcome([&]() { return referenceBestMove(&board, white); });
+    std::string recorded = expected;
+    if (baselinePath) {
+      recorded = "MISSING";
+      std::string result;
+      while (std::getline(baseline, result)) {
+        if (!result.empty() && result[0] != '#') {
+          recorded = result;
+          break;
+        }
+      }
+    }
+    // The prices differ from line to line, so no entry may outlive its position
+    transpositionTable.clear();
+    std::string cold = outcome([&]() {
+      return board.getBeamMove(white, board.getSearchDepth(), NO_DEADLINE);
+    });
+    std::string warm = outcome([&]() {
+      return board.getBeamMove(white, board.getSearchDepth(), NO_DEADLINE);
+    });
+
+    if (cold != expected || warm != expected || recorded != expected) {
+      ++mismatches;
+      std::cout << "MISMATCH line " << positions << ": reference " << expected << ", engine "
+                << cold << ", engine again " << warm;
+      if (baselinePath) {
+        std::cout << ", baseline " << recorded;
+      }
+      std::cout << std::endl;
+    } else {
+      std::cout << "ok " << positions << " difficulty " << board.getDifficulty() << ' '
+                << expected << std::endl;
+    }
+  }
+
+  std::cout << "positions " << positions << " mismatches " << mismatches << std::endl;
+  return mismatches == 0 && positions > 0 ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file   chess-perft.cpp
+ * @brief  Standalone perft benchmark of the move generator.
+ *
+ * Usage: chess-perft <depth> [divide] [--expect <nodes>] [position]
+ *
+ * Without a position the standard setup is counted with White to move. A position
+ * is the line `prestart` reads, whose last digit picks the side to move. Moves of
+ * the divide listing are written the way White types them. With --expect the
+ * exit status is non-zero unless exactly that many nodes were counted.
+ */
+
+#include "chess-perft.h"
+#include "chess-thread-pool.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    std::cerr << "usage: chess-perft <depth> [divide] [--expect <nodes>] [position]" << std::endl;
+    return 2;
+  }
+
+  int depth = std::atoi(argv[1]);
+  bool divide = false;
+  bool expect = false;
+  uint64_t expected = 0;
+  std::string position;
+  for (int i = 2; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "divide") {
+      divide = true;
+    } else if (arg == "--expect" && i + 1 < argc) {
+      expect = true;
+      expected = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      position = arg;
+    }
+  }
+
+  threadPool.resize(ThreadPool::defaultThreads());
+
+  try {
+    ChessBoard board(nullptr, 1);
+    bool white = true;
+    if (!position.empty()) {
+      board.makeBoardFromString(position);
+      white = position.back() - '0';
+    }
+
+    Perft_Result result = runPerft(&board, white, depth, divide);
+    for (const auto &entry : result.divide) {
+      Move move = unpackMove(entry.first);
+      std::cout << move.start.second << move.start.first << ':'
+                << move.end.second << move.end.first << ' ' << entry.second << std::endl;
+    }
+    std::cout << "nodes " << result.nodes << " time " << int64_t(result.seconds * 1000)
+              << " nps " << result.nodesPerSecond() << std::endl;
+
+    if (expect && result.nodes != expected) {
+      std::cerr << "EXPECTED " << expected << " NODES" << std::endl;
+      return 1;
+    }
+  } catch (std::exception &ex) {
+    std::cerr << ex.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}